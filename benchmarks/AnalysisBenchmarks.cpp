@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "include/Io/TrackTreeReader.hpp"
+#include "include/Io/SyntheticTracks.hpp"
+#include "include/Analysis/AnalysisEngine.hpp"
+#include "include/Analysis/BatchCuts.hpp"
+#include "include/Analysis/Cuts.hpp"
+#include "include/Analysis/EventStats.hpp"
+#include "include/Analysis/OverlapResolver.hpp"
+#include "include/Analysis/TrackHistogramSet.hpp"
+#include "include/Analysis/UnitRegistry.hpp"
+#include "include/detail/HelperFunctions.hpp"
+
+// Benchmarks of the analysis hot paths
+//
+// The stage benchmarks run on synthetic events with a
+// given number of tracks and hits per track, a tenth
+// of the tracks sharing a hit with an earlier one. The
+// reader and end-to-end benchmarks need a fitted-tracks
+// file or directory, given by ANALYSIS_BENCHMARK_INPUT,
+// and are skipped without it.
+//
+// Results in JSON for the comparison between commits:
+//   benchmarks --benchmark_out=results.json --benchmark_out_format=json
+
+namespace {
+    // Events with nTracks tracks of nHits hits each,
+    // cycled through by the benchmarks
+    std::vector<EventTracks> makeEvents(std::size_t nTracks, std::size_t nHits) {
+        SyntheticTracks::Config syntheticCfg;
+        syntheticCfg.meanTracks = nTracks;
+        syntheticCfg.poissonTracks = false;
+        syntheticCfg.nHits = nHits;
+        syntheticCfg.sharedHitRate = 0.1;
+        SyntheticTracks generator(syntheticCfg);
+
+        std::vector<EventTracks> events(16);
+        for (std::uint32_t e = 0; e < events.size(); e++) {
+            generator.generate(e + 1, events[e]);
+        }
+        return events;
+    }
+
+    // Tracks of four hits pass the ndf cut
+    void multiplicities(benchmark::internal::Benchmark* benchmark) {
+        for (int nTracks : {1, 8, 64, 512}) {
+            benchmark->Args({nTracks, 4});
+        }
+    }
+
+    void multiplicitiesAndHits(benchmark::internal::Benchmark* benchmark) {
+        for (int nTracks : {8, 64, 512, 2048}) {
+            for (int nHits : {4, 8, 16}) {
+                benchmark->Args({nTracks, nHits});
+            }
+        }
+    }
+
+    // Tracks per second, reported as items_per_second
+    void setTrackCounters(benchmark::State& state, std::size_t nTracksPerIteration) {
+        state.SetItemsProcessed(state.iterations() * nTracksPerIteration);
+    }
+
+    // Input of the reader benchmarks
+    const char* benchmarkInput() {
+        return std::getenv("ANALYSIS_BENCHMARK_INPUT");
+    }
+} // namespace
+
+// Per-track cuts through the runtime getters
+static void BM_ProcessTrack(benchmark::State& state) {
+    const auto events = makeEvents(state.range(0), state.range(1));
+    Cuts cuts;
+    EventStats evStat;
+    std::size_t e = 0;
+    for (auto _ : state) {
+        const auto& tracks = events[e++ % events.size()];
+        for (std::size_t i = 0; i < tracks.size(); i++) {
+            benchmark::DoNotOptimize(processTrack(tracks.view(i), evStat, cuts));
+        }
+    }
+    setTrackCounters(state, state.range(0));
+}
+BENCHMARK(BM_ProcessTrack)->Apply(multiplicities);
+
+// Per-track cuts through the statically dispatched getters
+static void BM_ProcessTrackStatic(benchmark::State& state) {
+    const auto events = makeEvents(state.range(0), state.range(1));
+    Cuts cuts;
+    EventStats evStat;
+    std::size_t e = 0;
+    for (auto _ : state) {
+        const auto& tracks = events[e++ % events.size()];
+        for (std::size_t i = 0; i < tracks.size(); i++) {
+            benchmark::DoNotOptimize(
+                UnitRegistry::processTrack(tracks.view(i), evStat, cuts));
+        }
+    }
+    setTrackCounters(state, state.range(0));
+}
+BENCHMARK(BM_ProcessTrackStatic)->Apply(multiplicities);
+
+// Cut masks of all tracks of an event at once
+static void BM_BatchCuts(benchmark::State& state) {
+    const auto events = makeEvents(state.range(0), state.range(1));
+    Cuts cuts;
+    BatchCuts batchCuts;
+    std::size_t e = 0;
+    for (auto _ : state) {
+        const auto& tracks = events[e++ % events.size()];
+        benchmark::DoNotOptimize(batchCuts.evaluate(tracks, cuts, true).data());
+    }
+    setTrackCounters(state, state.range(0));
+}
+BENCHMARK(BM_BatchCuts)->Apply(multiplicities);
+
+// Histogram filling one track at a time
+static void BM_HistogramFill(benchmark::State& state) {
+    const auto events = makeEvents(state.range(0), state.range(1));
+    TrackHistogramSet histSet("bench");
+    std::size_t e = 0;
+    for (auto _ : state) {
+        const auto& tracks = events[e++ % events.size()];
+        for (std::size_t i = 0; i < tracks.size(); i++) {
+            histSet.fill(tracks.view(i));
+        }
+    }
+    setTrackCounters(state, state.range(0));
+}
+BENCHMARK(BM_HistogramFill)->Apply(multiplicities);
+
+// Histogram filling of all tracks of an event, unit by unit
+static void BM_HistogramFillBatch(benchmark::State& state) {
+    const auto events = makeEvents(state.range(0), state.range(1));
+    TrackHistogramSet histSet("bench");
+    std::vector<std::uint32_t> selected(state.range(0));
+    std::iota(selected.begin(), selected.end(), 0);
+    std::size_t e = 0;
+    for (auto _ : state) {
+        histSet.fill(events[e++ % events.size()], selected, true);
+    }
+    setTrackCounters(state, state.range(0));
+}
+BENCHMARK(BM_HistogramFillBatch)->Apply(multiplicities);
+
+// Overlap flags through the pairwise scan and the hit index
+//
+// The resolver only sets flags, so the events are reused
+// and only their flags are cleared, pausing the timer
+// would cost more than resolving a small event
+static void BM_RemoveOverlaps(benchmark::State& state, OverlapMethod method) {
+    auto events = makeEvents(state.range(0), state.range(1));
+    OverlapResolver resolver({method, 1});
+    std::size_t e = 0;
+    for (auto _ : state) {
+        EventTracks& tracks = events[e++ % events.size()];
+        std::ranges::fill(tracks.isOverlap, false);
+
+        resolver.resolve(tracks);
+        benchmark::DoNotOptimize(tracks.isOverlap.data());
+    }
+    setTrackCounters(state, state.range(0));
+}
+BENCHMARK_CAPTURE(BM_RemoveOverlaps, Pairwise, OverlapMethod::Pairwise)
+    ->Apply(multiplicitiesAndHits);
+BENCHMARK_CAPTURE(BM_RemoveOverlaps, Hashed, OverlapMethod::Hashed)
+    ->Apply(multiplicitiesAndHits);
+
+// Cut flow histograms and confidence intervals
+static void BM_GetCutFlow(benchmark::State& state, IntervalMethod method) {
+    CutFlowSummary summary;
+    summary.nEvents = 100000;
+    for (std::size_t k = 0; k < summary.sum.size(); k++) {
+        summary.sum[k] = 50000.0 / (k + 1);
+        summary.accept[k] = 40000.0 / (k + 1);
+    }
+    for (auto _ : state) {
+        auto [cutFlow, cutFlowErrs] = getCutFlow(summary, "bench", -1, method);
+        benchmark::DoNotOptimize(cutFlow);
+        delete cutFlow;
+        delete cutFlowErrs;
+    }
+}
+BENCHMARK_CAPTURE(BM_GetCutFlow, ProfileLikelihood, IntervalMethod::ProfileLikelihood);
+BENCHMARK_CAPTURE(BM_GetCutFlow, Wilson, IntervalMethod::Wilson);
+BENCHMARK_CAPTURE(BM_GetCutFlow, ClopperPearson, IntervalMethod::ClopperPearson);
+
+// Random access to the events of the input
+static void BM_GetTracksForEvent(benchmark::State& state) {
+    if (!benchmarkInput()) {
+        state.SkipWithError("ANALYSIS_BENCHMARK_INPUT not set");
+        return;
+    }
+    TrackTreeReader::Config trackTreeReaderCfg;
+    trackTreeReaderCfg.filePath = benchmarkInput();
+    trackTreeReaderCfg.columns = AnalysisEngine::requiredColumns();
+    TrackTreeReader trackTreeReader(trackTreeReaderCfg);
+
+    auto events = trackTreeReader.getEvents();
+    std::shuffle(events.begin(), events.end(), std::mt19937(1));
+    std::size_t e = 0;
+    std::size_t nTracks = 0;
+    for (auto _ : state) {
+        auto tracks = trackTreeReader.getTracksForEvent(events[e++ % events.size()]);
+        nTracks += tracks.size();
+        benchmark::DoNotOptimize(tracks.data());
+    }
+    state.counters["events/s"] = benchmark::Counter(
+        state.iterations(), benchmark::Counter::kIsRate);
+    state.counters["tracks/s"] = benchmark::Counter(
+        nTracks, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_GetTracksForEvent)->Unit(benchmark::kMicrosecond);
+
+// Full analysis of the input on a single thread,
+// reading included
+static void BM_EndToEnd(benchmark::State& state) {
+    if (!benchmarkInput()) {
+        state.SkipWithError("ANALYSIS_BENCHMARK_INPUT not set");
+        return;
+    }
+    TrackTreeReader::Config trackTreeReaderCfg;
+    trackTreeReaderCfg.filePath = benchmarkInput();
+    trackTreeReaderCfg.columns = AnalysisEngine::requiredColumns();
+    TrackTreeReader trackTreeReader(trackTreeReaderCfg);
+
+    Cuts cuts;
+    std::size_t nEvents = 0;
+    for (auto _ : state) {
+        AnalysisEngine engine(cuts);
+        trackTreeReader.forEachEvent(
+            [&engine] (std::uint32_t id, EventTracks& tracks) {
+                engine.processEvent(id, tracks);
+            }
+        );
+        nEvents += engine.nEvents();
+        benchmark::DoNotOptimize(engine.nTracks());
+    }
+    state.counters["events/s"] = benchmark::Counter(
+        nEvents, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_EndToEnd)->Unit(benchmark::kMillisecond)->Iterations(3);
+
+BENCHMARK_MAIN();
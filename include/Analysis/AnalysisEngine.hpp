@@ -0,0 +1,256 @@
+#pragma once
+
+#include "include/Types/Track.hpp"
+#include "include/Types/EventTracks.hpp"
+#include "include/Analysis/BatchCuts.hpp"
+#include "include/Analysis/Cuts.hpp"
+#include "include/Analysis/EventStats.hpp"
+#include "include/Analysis/HourglassFilter.hpp"
+#include "include/Analysis/OverlapResolver.hpp"
+#include "include/Analysis/PartialResult.hpp"
+#include "include/Analysis/TrackHistogramSet.hpp"
+#include "include/Analysis/UnitRegistry.hpp"
+#include "include/detail/HelperFunctions.hpp"
+#include "include/detail/Profiler.hpp"
+
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "TFile.h"
+
+// Single-pass analysis that dispatches every track
+// to the histogram set and event statistics
+// of its matching degree
+class AnalysisEngine {
+    public:
+        // Per-matching-degree analysis state
+        struct DegreeState {
+            /// Cuts with the matching degree
+            /// cut fixed to this degree
+            Cuts cuts;
+
+            /// Histograms of the tracks
+            /// passing the cuts
+            TrackHistogramSet histSet;
+
+            /// Cut flow summed over the processed events
+            CutFlowSummary cutFlow;
+
+            /// Cut flow of the current event
+            CutFlow eventFlow;
+
+            /// Tracks of the current event passing the cuts
+            std::vector<std::uint32_t> selected;
+        };
+
+        AnalysisEngine(const Cuts& cuts = Cuts()) : 
+            m_cuts(cuts),
+            m_overlapResolver(cuts.overlaps),
+            m_static(UnitRegistry::matches(units) && UnitRegistry::matches(cuts)) {
+                if (cuts.hourglass.has_value()) {
+                    m_hourglass.emplace(cuts.hourglass.value());
+                }
+        }
+
+        // Tree columns needed by the analysis units
+        // and the overlap/multiplicity post-processing
+        static std::vector<std::string> requiredColumns() {
+            auto columns = ::requiredColumns(units);
+            columns.insert(columns.end(), 
+                postProcessingColumns.begin(), postProcessingColumns.end());
+
+            std::sort(columns.begin(), columns.end());
+            auto last = std::unique(columns.begin(), columns.end());
+            columns.erase(last, columns.end());
+
+            return columns;
+        }
+
+        // Process the tracks of a single event
+        //
+        // @par eventId: id of the event
+        // @par tracks: tracks of the event
+        void processEvent(std::uint32_t eventId, EventTracks& tracks) {
+            Profiler::addEvent();
+
+            // Skims carry the flags of the full event
+            if (!tracks.hasStoredFlags) {
+                {
+                    ScopedTimer timer(Stage::RemoveOverlaps);
+                    m_overlapResolver.resolve(tracks);
+                }
+                ScopedTimer timer(Stage::RemoveMultiple);
+                removeMultiple(tracks);
+            }
+
+            m_nEvents++;
+
+            ScopedTimer cutsTimer(Stage::Cuts);
+
+            // Degrees only differ in the matching degree 
+            // cut, which is redone per track below
+            const auto& masks = m_batchCuts.evaluate(tracks, m_cuts, m_static);
+            const auto nCuts = m_cuts.cuts.size();
+
+            // Overlaps and multiplicity are still
+            // decided among all tracks of the event
+            if (m_hourglass.has_value()) {
+                m_hourglass->count(tracks.trackHits, tracks.size());
+            }
+
+            m_eventDegrees.clear();
+            for (auto i : tracks.order) {
+                if (m_hourglass.has_value() && !m_hourglass->passes(i)) {
+                    continue;
+                }
+                const TrackView track = tracks.view(i);
+
+                auto& degree = getDegreeState(track.matchingDegree);
+                if (std::ranges::find(m_eventDegrees, &degree) == m_eventDegrees.end()) {
+                    m_eventDegrees.push_back(&degree);
+                }
+
+                const auto& degreeCut = degree.cuts.cuts.front();
+                const double value = degreeCut.getter(track);
+                const auto mask = BatchCuts::setCut(masks[i], 0,
+                    !(degreeCut.range.first > value || degreeCut.range.second < value));
+
+                const auto nPassed = BatchCuts::nPassed(mask);
+                for (std::size_t k = 0; k < nPassed && k < nCuts; k++) {
+                    degree.eventFlow.flow[k]++;
+                }
+                if (nPassed < nCuts) {
+                    continue;
+                }
+                m_nTracks++;
+
+                degree.selected.push_back(i);
+            }
+
+            cutsTimer.stop();
+
+            // Events without tracks of a degree only enter
+            // its cut flow through the number of events
+            ScopedTimer fillTimer(Stage::FillHistograms);
+            for (auto* degree : m_eventDegrees) {
+                degree->histSet.fill(tracks, degree->selected, m_static);
+                degree->selected.clear();
+
+                degree->cutFlow.add(degree->eventFlow);
+                std::ranges::fill(degree->eventFlow.flow, 0);
+            }
+        }
+
+        // Merge the results of an engine that
+        // processed a different set of events
+        void merge(const AnalysisEngine& other) {
+            for (const auto& [matchingDegree, otherDegree] : other.m_degrees) {
+                auto& degree = getDegreeState(matchingDegree);
+                degree.histSet.add(otherDegree.histSet);
+                degree.cutFlow.add(otherDegree.cutFlow);
+            }
+            m_nEvents += other.m_nEvents;
+            m_nTracks += other.m_nTracks;
+        }
+
+        // Count events without any tracks, e.g. the
+        // events of the input that are absent from a skim
+        void addEmptyEvents(std::size_t nEvents) {
+            m_nEvents += nEvents;
+        }
+
+        // Clear the results, keeping the histograms
+        // of the seen degrees for the next events
+        void reset() {
+            for (auto& [matchingDegree, degree] : m_degrees) {
+                degree.histSet.reset();
+                degree.cutFlow.reset();
+            }
+            m_nEvents = 0;
+            m_nTracks = 0;
+        }
+
+        // Raw results for merging with other shards,
+        // sharing the histograms of the engine
+        PartialResult partialResult() const {
+            PartialResult result;
+            for (const auto& [matchingDegree, degree] : m_degrees) {
+                result.degrees.emplace(
+                    matchingDegree,
+                    PartialResult::DegreeResult{degree.histSet, degree.cutFlow});
+            }
+            result.nTracks = m_nTracks;
+            result.nEvents = m_nEvents;
+            return result;
+        }
+
+        // Write the histograms and cut flows
+        // of every matching degree
+        void store(
+            TFile* outFile, 
+            IntervalMethod method = IntervalMethod::ProfileLikelihood) const {
+                partialResult().store(outFile, method);
+        }
+
+        // Number of tracks passing all cuts
+        double nTracks() const {
+            return m_nTracks;
+        }
+
+        // Number of processed events
+        std::size_t nEvents() const {
+            return m_nEvents;
+        }
+
+        const std::map<double, DegreeState>& degrees() const {
+            return m_degrees;
+        }
+
+    private:
+        Cuts m_cuts;
+
+        // Overlap index buffers, reused across events
+        OverlapResolver m_overlapResolver;
+
+        // Units and cuts match the registry and
+        // the getters are dispatched statically
+        bool m_static;
+
+        // Cut evaluation buffers, reused across events
+        BatchCuts m_batchCuts;
+
+        // Hit counts of the hourglass pre-filter, if any
+        std::optional<HourglassCounter> m_hourglass;
+
+        std::map<double, DegreeState> m_degrees;
+
+        std::size_t m_nEvents = 0;
+
+        // Degrees with tracks in the current event
+        std::vector<DegreeState*> m_eventDegrees;
+
+        double m_nTracks = 0;
+
+        // Get the state of the matching degree,
+        // creating it on first encounter
+        DegreeState& getDegreeState(double matchingDegree) {
+            auto it = m_degrees.find(matchingDegree);
+            if (it != m_degrees.end()) {
+                return it->second;
+            }
+            Cuts cuts = m_cuts;
+            cuts.cuts.at(0).range = {matchingDegree, matchingDegree};
+
+            return m_degrees.emplace(
+                matchingDegree,
+                DegreeState{
+                    cuts,
+                    TrackHistogramSet(std::to_string(matchingDegree)),
+                    CutFlowSummary(cuts.cuts.size()),
+                    CutFlow(cuts.cuts.size()),
+                    {}}).first->second;
+        }
+};
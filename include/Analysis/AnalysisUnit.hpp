@@ -2,8 +2,14 @@
 
 #include "include/Types/Track.hpp"
 
+#include <algorithm>
+#include <array>
 #include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
 #include <utility>
+#include <vector>
 
 using Range = std::pair<double, double>;
 
@@ -32,175 +38,245 @@ struct AnalysisUnit {
     //--------------------------------
     // Getter function
     Track::Getter getter;
+
+    // Tree columns read by the getter
+    std::vector<std::string> columns;
 };
 
 
-static std::vector<AnalysisUnit> units{
+// Analysis unit with the getter bound at compile time,
+// so that loops over the registry can inline it
+template <auto& getter>
+struct StaticUnit {
+    // General unit identifier
+    std::string_view name;
+
+    // Range of the cut
+    std::optional<Range> range;
+
+    // Histogram parameters
+    int nBins;
+    double low;
+    double high;
+
+    // Tree columns read by the getter
+    std::array<std::string_view, 2> columns;
+
+    static double get(const TrackView& track) {
+        return getter(track);
+    }
+
+    // Whether a type-erased getter holds this getter,
+    // every registry getter has its own closure type
+    static bool holds(const Track::Getter& other) {
+        return other.template target<std::remove_cvref_t<decltype(getter)>>() != nullptr;
+    }
+
+    // Runtime unit with the same parameters
+    AnalysisUnit toAnalysisUnit() const {
+        AnalysisUnit unit{
+            std::string(name), range, nBins, low, high, getter, {}};
+        for (auto column : columns) {
+            if (!column.empty()) {
+                unit.columns.emplace_back(column);
+            }
+        }
+        return unit;
+    }
+};
+
+// Registry of the analysis units, known at compile time
+inline constexpr auto staticUnits = std::make_tuple(
     /// ---------------------------------------------
     /// D.o.F. performance
 
     // Matching degree
-    {"matchingDegree", 
-        std::optional<Range>({0, 1}), 
+    StaticUnit<TrackGetters::matchingDegree>{"matchingDegree", 
+        Range{0, 1}, 
         // std::nullopt,
         100, 0, 1, 
-        TrackGetters::matchingDegree},
+        {"matchingDegree"}},
 
     // Number of degrees of freedom
-    {"ndf", 
-        std::optional<Range>({8, 8}), 
+    StaticUnit<TrackGetters::ndf>{"ndf", 
+        Range{8, 8}, 
         // std::nullopt,
         100, 0, 100, 
-        TrackGetters::ndf},
+        {"ndf"}},
 
     /// ---------------------------------------------
     /// Inter-track performance
 
     // Overlap flag
-    {"isOverlap", 
-        std::optional<Range>({0, 0}), 
+    StaticUnit<TrackGetters::isOverlap>{"isOverlap", 
+        Range{0, 0}, 
         // std::nullopt,
         2, 0, 1, 
-        TrackGetters::isOverlap},
+        {}},
 
     // Multiple tracks in event flag
-    {"isMultiple", 
-        std::optional<Range>({0, 0}), 
+    StaticUnit<TrackGetters::isMultiple>{"isMultiple", 
+        Range{0, 0}, 
         // std::nullopt,
         2, 0, 1, 
-        TrackGetters::isMultiple},
+        {}},
 
     /// ---------------------------------------------
     /// KF fit performance
 
     // Chi2/ndf
-    {"chi2ndf", 
-        std::optional<Range>({0, 2.2}), 
+    StaticUnit<TrackGetters::chi2ndf>{"chi2ndf", 
+        Range{0, 2.2}, 
         // std::nullopt,
         100, 0, 3.0, 
-        TrackGetters::chi2ndf},
+        {"chi2", "ndf"}},
 
     /// ---------------------------------------------
     /// KF-estimated kinematics
 
     // Momentum in x
-    {"ipPx", 
+    StaticUnit<TrackGetters::ipPx>{"ipPx", 
         // {-0.08, 0.08}, 
         std::nullopt,
         100, -0.1, 0.1, 
-        TrackGetters::ipPx},
+        {"ipMomentum"}},
 
     // Momentum in y
-    {"ipPy", 
+    StaticUnit<TrackGetters::ipPy>{"ipPy", 
         // {-0.5, 0.5}, 
         std::nullopt,
         100, 1, 4.5, 
-        TrackGetters::ipPy},
+        {"ipMomentum"}},
 
     // Momentum in z
-    {"ipPz", 
+    StaticUnit<TrackGetters::ipPz>{"ipPz", 
         // {-0.5, 0.5}, 
         std::nullopt,
         100, -0.5, 0.5, 
-        TrackGetters::ipPz},
+        {"ipMomentum"}},
 
     // Energy
-    {"E", 
+    StaticUnit<TrackGetters::E>{"E", 
         // {2, 4}, 
         std::nullopt,
         100, 1, 4.5, 
-        TrackGetters::E},
+        {"ipMomentum"}},
 
     /// ---------------------------------------------
     /// Truth kinematics
 
     // Momentum in x
-    {"ipPxTruth", 
+    StaticUnit<TrackGetters::ipPxTruth>{"ipPxTruth", 
         // {-0.08, 0.08}, 
         std::nullopt,
         100, -0.02, 0.02, 
-        TrackGetters::ipPxTruth},
+        {"ipMomentumTruth"}},
 
     // Momentum in y
-    {"ipPyTruth", 
+    StaticUnit<TrackGetters::ipPyTruth>{"ipPyTruth", 
         // {-0.5, 0.5}, 
         std::nullopt,
         100, 1, 4.5, 
-        TrackGetters::ipPyTruth},
+        {"ipMomentumTruth"}},
 
     // Momentum in z
-    {"ipPzTruth", 
+    StaticUnit<TrackGetters::ipPzTruth>{"ipPzTruth", 
         // {-0.5, 0.5}, 
         std::nullopt,
         100, -0.01, 0.01, 
-        TrackGetters::ipPzTruth},
+        {"ipMomentumTruth"}},
 
     // Energy
-    {"ETruth", 
+    StaticUnit<TrackGetters::ETruth>{"ETruth", 
         // {2, 4}, 
         std::nullopt,
         100, 1, 4.5, 
-        TrackGetters::ETruth},
+        {"ipMomentumTruth"}},
 
     /// ---------------------------------------------
     /// Kinematics errors
 
     // Momentum in x
-    {"ipPxErr", 
+    StaticUnit<TrackGetters::ipPxErr>{"ipPxErr", 
         // {-0.08, 0.08}, 
         std::nullopt,
         1000, -1000, 1000, 
-        TrackGetters::ipPxErr},
+        {"ipMomentum", "ipMomentumTruth"}},
 
     // Momentum in y
-    {"ipPyErr", 
+    StaticUnit<TrackGetters::ipPyErr>{"ipPyErr", 
         // {-0.5, 0.5}, 
         std::nullopt,
         100, -0.2, 0.2, 
-        TrackGetters::ipPyErr},
+        {"ipMomentum", "ipMomentumTruth"}},
 
     // Momentum in z
-    {"ipPzErr", 
+    StaticUnit<TrackGetters::ipPzErr>{"ipPzErr", 
         // {-0.5, 0.5}, 
         std::nullopt,
         1000, -1000, 1000, 
-        TrackGetters::ipPzErr},
+        {"ipMomentum", "ipMomentumTruth"}},
 
     // Energy
-    {"EErr", 
+    StaticUnit<TrackGetters::EErr>{"EErr", 
         // {2, 4}, 
         std::nullopt,
         100, -0.2, 0.2, 
-        TrackGetters::EErr},
+        {"ipMomentum", "ipMomentumTruth"}},
 
     /// ---------------------------------------------
     /// Significances
 
     // Vertex x significance
-    {"vertexXSignificance", 
+    StaticUnit<TrackGetters::vertexXSignificance>{"vertexXSignificance", 
         // {-3, 3}, 
         std::nullopt,
         100, -10, 10, 
-        TrackGetters::vertexXSignificance},
+        {"vertex", "vertexError"}},
 
     // Vertex z significance
-    {"vertexZSignificance", 
+    StaticUnit<TrackGetters::vertexZSignificance>{"vertexZSignificance", 
         // {-27, 27}, 
         std::nullopt,
         100, -30, 30, 
-        TrackGetters::vertexZSignificance},
+        {"vertex", "vertexError"}},
 
     // Momentum phi significance
-    {"ipMomentumPhiSignificance", 
+    StaticUnit<TrackGetters::ipMomentumPhiSignificance>{"ipMomentumPhiSignificance", 
         // {-1, 1}, 
         std::nullopt,
         100, -40, 40, 
-        TrackGetters::ipMomentumPhiSignificance},
+        {"ipMomentum", "ipMomentumError"}},
 
     // Momentum theta significance
-    {"ipMomentumThetaSignificance", 
+    StaticUnit<TrackGetters::ipMomentumThetaSignificance>{"ipMomentumThetaSignificance", 
         // {-10, 20}, 
         std::nullopt,
         200, -60, 80, 
-        TrackGetters::ipMomentumThetaSignificance}
-};
+        {"ipMomentum", "ipMomentumError"}}
+);
+
+// Runtime units, built from the registry and open to
+// modification. Analyses on modified units fall back
+// to the type-erased getters
+static std::vector<AnalysisUnit> units = std::apply(
+    [] (const auto&... unit) {
+        return std::vector<AnalysisUnit>{unit.toAnalysisUnit()...};
+    }, 
+    staticUnits);
+
+// Collect the tree columns read by the units
+inline std::vector<std::string> requiredColumns(
+    const std::vector<AnalysisUnit>& analysisUnits) {
+        std::vector<std::string> columns;
+        for (const auto& unit : analysisUnits) {
+            columns.insert(columns.end(), 
+                unit.columns.begin(), unit.columns.end());
+        }
+        std::sort(columns.begin(), columns.end());
+        
+        auto last = std::unique(columns.begin(), columns.end());
+        columns.erase(last, columns.end());
+
+        return columns;
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "include/Analysis/AnalysisUnit.hpp"
+#include "include/Analysis/Cuts.hpp"
+#include "include/Analysis/UnitRegistry.hpp"
+#include "include/Types/EventTracks.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+// Bit k is set if the track passes cut k
+using CutMask = std::uint32_t;
+
+// Cut evaluation over all tracks of an event at once
+//
+// Every cut is evaluated column by column: the getter
+// values of all tracks are gathered first and compared
+// against the range in a branch-free loop the compiler
+// can vectorize. With the registry cuts the values are
+// read straight from the event columns, other getters
+// are gathered through a view of every track. The result
+// is a mask per track of the cuts it passes, independent
+// of the cut order.
+class BatchCuts {
+    public:
+        static constexpr std::size_t maxCuts = 8 * sizeof(CutMask);
+
+        // Evaluate the cuts on the tracks of an event
+        //
+        // @par tracks: tracks of the event
+        // @par cuts: cuts to evaluate
+        // @par isStatic: cuts match the unit registry
+        // and the getters are dispatched statically
+        //
+        // @return: pass mask of every track, indexed
+        // as the tracks in the container
+        const std::vector<CutMask>& evaluate(
+            const EventTracks& tracks,
+            const Cuts& cuts,
+            bool isStatic) {
+                if (cuts.cuts.size() > maxCuts) {
+                    throw std::invalid_argument("Too many cuts for the cut mask");
+                }
+                const std::size_t n = tracks.size();
+                m_masks.assign(n, 0);
+                m_values.resize(n);
+
+                if (isStatic) {
+                    UnitRegistry::forEach(
+                        [&] (const auto& unit, auto I) {
+                            using Unit = std::remove_cvref_t<decltype(unit)>;
+                            if constexpr (std::get<I>(staticUnits).range.has_value()) {
+                                gather<Unit>(tracks);
+                                constexpr auto k = UnitRegistry::cutIndex<I>();
+                                applyRange(cuts.cuts[k].range, k);
+                            }
+                        }
+                    );
+                    return m_masks;
+                }
+
+                for (std::size_t k = 0; k < cuts.cuts.size(); k++) {
+                    const auto& cut = cuts.cuts[k];
+                    for (std::size_t i = 0; i < n; i++) {
+                        m_values[i] = cut.getter(tracks.view(i));
+                    }
+                    applyRange(cut.range, k);
+                }
+                return m_masks;
+        }
+
+        // Number of leading cuts passed, the cut
+        // flow of a track evaluated in cut order
+        static std::size_t nPassed(CutMask mask) {
+            return std::countr_one(mask);
+        }
+
+        // Whether the track passes all cuts
+        static bool passes(CutMask mask, std::size_t nCuts) {
+            return nPassed(mask) >= nCuts;
+        }
+
+        // Set or clear the bit of a cut
+        static CutMask setCut(CutMask mask, std::size_t cut, bool pass) {
+            return (mask & ~(CutMask(1) << cut)) | (CutMask(pass) << cut);
+        }
+
+    private:
+        std::vector<CutMask> m_masks;
+
+        // Getter values of the current cut
+        std::vector<double> m_values;
+
+        // Gather the values of a registry unit, reading
+        // the event columns directly for the getters
+        // computed from the columns alone
+        template <typename Unit>
+        void gather(const EventTracks& tracks) {
+            const std::size_t n = tracks.size();
+            double* values = m_values.data();
+            if constexpr (std::is_same_v<Unit, StaticUnit<TrackGetters::matchingDegree>>) {
+                const double* matchingDegree = tracks.matchingDegree.data();
+                for (std::size_t i = 0; i < n; i++) {
+                    values[i] = matchingDegree[i];
+                }
+            }
+            else if constexpr (std::is_same_v<Unit, StaticUnit<TrackGetters::ndf>>) {
+                const int* ndf = tracks.ndf.data();
+                for (std::size_t i = 0; i < n; i++) {
+                    values[i] = ndf[i];
+                }
+            }
+            else if constexpr (std::is_same_v<Unit, StaticUnit<TrackGetters::isOverlap>>) {
+                const std::uint8_t* isOverlap = tracks.isOverlap.data();
+                for (std::size_t i = 0; i < n; i++) {
+                    values[i] = bool(isOverlap[i]);
+                }
+            }
+            else if constexpr (std::is_same_v<Unit, StaticUnit<TrackGetters::isMultiple>>) {
+                const std::uint8_t* isMultiple = tracks.isMultiple.data();
+                for (std::size_t i = 0; i < n; i++) {
+                    values[i] = bool(isMultiple[i]);
+                }
+            }
+            else if constexpr (std::is_same_v<Unit, StaticUnit<TrackGetters::chi2ndf>>) {
+                const double* chi2 = tracks.chi2.data();
+                const int* ndf = tracks.ndf.data();
+                for (std::size_t i = 0; i < n; i++) {
+                    values[i] = chi2[i] / ndf[i];
+                }
+            }
+            else {
+                for (std::size_t i = 0; i < n; i++) {
+                    values[i] = Unit::get(tracks.view(i));
+                }
+            }
+        }
+
+        // Set bit k of the tracks inside the range,
+        // values outside neither bound, e.g. NaN,
+        // pass like in processTrack
+        void applyRange(const Range& range, std::size_t k) {
+            const double low = range.first;
+            const double high = range.second;
+            const std::size_t n = m_values.size();
+            const double* values = m_values.data();
+            CutMask* masks = m_masks.data();
+            for (std::size_t i = 0; i < n; i++) {
+                const bool fail = (low > values[i]) | (high < values[i]);
+                masks[i] |= CutMask(!fail) << k;
+            }
+        }
+};
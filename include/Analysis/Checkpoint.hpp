@@ -0,0 +1,232 @@
+#pragma once
+
+#include "include/Analysis/AnalysisEngine.hpp"
+#include "include/Analysis/PartialResult.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "TFile.h"
+#include "TObjString.h"
+
+// Periodic checkpoints of a running analysis
+//
+// A checkpoint is a partial result file extended by
+// the list of processed inputs: every file of the
+// dataset with its size, modification time and the
+// number of its events, in file order, already in
+// the result. Work is planned per file, so a job
+// started again with the same checkpoint resumes
+// where the last one stopped, and a job started after
+// new files arrived only processes the new files.
+class Checkpoint {
+    public:
+        struct Config {
+            /// Checkpoint file, read on construction
+            /// if it exists and rewritten in place
+            std::string path;
+
+            /// Number of events per chunk
+            std::size_t chunkSize = 1000;
+
+            /// Minimal time between two checkpoints
+            std::chrono::seconds interval{600};
+        };
+
+        // Processing state of an input file
+        struct Input {
+            std::string path;
+            std::uintmax_t size = 0;
+            std::int64_t modified = 0;
+
+            /// Events of the file in the result,
+            /// the first ones in file order
+            std::size_t nProcessed = 0;
+        };
+
+        Checkpoint(const Config& cfg) :
+            m_cfg(cfg),
+            m_lastWrite(std::chrono::steady_clock::now()) {
+                if (!std::filesystem::exists(cfg.path)) {
+                    return;
+                }
+                TFile* file = TFile::Open(cfg.path.c_str(), "READ");
+                if (!file || file->IsZombie()) {
+                    throw std::invalid_argument("Cannot open checkpoint " + cfg.path);
+                }
+                m_base = PartialResult::read(file);
+                m_inputs = parseInputs(
+                    PartialResult::getObject<TObjString>(file, "processedInputs")->GetName());
+                file->Close();
+                delete file;
+        }
+
+        // Split the events not in the checkpoint into chunks
+        //
+        // Chunks never span files, which lets every merged
+        // chunk be attributed to its file. Files changed
+        // since the checkpoint cannot be resumed.
+        //
+        // @par reader: reader of the dataset, a TrackTreeReader
+        // or a ColumnarTrackReader
+        //
+        // @return: event ids of every chunk, in merge order
+        template <typename Reader>
+        std::vector<std::vector<std::uint32_t>> plan(const Reader& reader) {
+            std::vector<std::vector<std::uint32_t>> chunks;
+            m_chunkInputs.clear();
+            m_chunkSizes.clear();
+
+            const std::size_t chunkSize = std::max<std::size_t>(m_cfg.chunkSize, 1);
+            const auto& filePaths = reader.getFilePaths();
+            for (std::size_t i = 0; i < filePaths.size(); i++) {
+                const auto events = reader.getEventsInFile(i);
+                const std::size_t inputIdx = getInput(filePaths.at(i));
+                const auto& input = m_inputs.at(inputIdx);
+                if (input.nProcessed > events.size()) {
+                    throw std::invalid_argument(
+                        "Checkpoint has more events than " + input.path);
+                }
+                for (std::size_t first = input.nProcessed; first < events.size(); first += chunkSize) {
+                    auto last = std::min(first + chunkSize, events.size());
+                    chunks.emplace_back(events.begin() + first, events.begin() + last);
+                    m_chunkInputs.push_back(inputIdx);
+                    m_chunkSizes.push_back(last - first);
+                }
+            }
+            return chunks;
+        }
+
+        // Write a checkpoint if the interval has passed
+        //
+        // Chunks are dispatched and merged in plan order,
+        // so the merged prefix follows the progress of all
+        // workers. Called by the merging worker outside the
+        // merge lock, the other workers keep processing
+        // while the checkpoint is written.
+        //
+        // @par merged: engine with the merged results
+        // of the first nMerged planned chunks
+        // @par nMerged: number of merged chunks
+        void update(const AnalysisEngine& merged, std::size_t nMerged) {
+            if (std::chrono::steady_clock::now() - m_lastWrite >= m_cfg.interval) {
+                write(merged, nMerged);
+            }
+        }
+
+        // Write a checkpoint of the checkpointed results
+        // and the first nMerged planned chunks
+        //
+        // The file is written next to the checkpoint and
+        // renamed over it, a crash while writing keeps
+        // the previous checkpoint intact and a failed 
+        // write removes the temporary file.
+        void write(const AnalysisEngine& merged, std::size_t nMerged) {
+            auto inputs = m_inputs;
+            for (std::size_t k = 0; k < nMerged; k++) {
+                inputs.at(m_chunkInputs.at(k)).nProcessed += m_chunkSizes.at(k);
+            }
+
+            const std::string tmpPath = m_cfg.path + ".tmp";
+            try {
+                TFile* file = new TFile(tmpPath.c_str(), "RECREATE");
+                if (file->IsZombie()) {
+                    delete file;
+                    throw std::runtime_error("Cannot write checkpoint " + tmpPath);
+                }
+                result(merged).write(file);
+                TObjString(formatInputs(inputs).c_str()).Write("processedInputs");
+                file->Close();
+                delete file;
+                std::filesystem::rename(tmpPath, m_cfg.path);
+            }
+            catch (...) {
+                std::error_code ec;
+                std::filesystem::remove(tmpPath, ec);
+                throw;
+            }
+
+            m_lastWrite = std::chrono::steady_clock::now();
+        }
+
+        // Checkpointed results merged with the
+        // results of the planned chunks
+        PartialResult result(const AnalysisEngine& merged) const {
+            PartialResult result = m_base;
+            result.merge(merged.partialResult());
+            return result;
+        }
+
+        const std::vector<Input>& getInputs() const {
+            return m_inputs;
+        }
+
+    private:
+        Config m_cfg;
+
+        std::chrono::steady_clock::time_point m_lastWrite;
+
+        /// Results in the checkpoint
+        PartialResult m_base;
+
+        /// Inputs in the checkpoint, followed
+        /// by the new inputs of the plan
+        std::vector<Input> m_inputs;
+
+        /// Input and number of events
+        /// of every planned chunk
+        std::vector<std::size_t> m_chunkInputs;
+        std::vector<std::size_t> m_chunkSizes;
+
+        // Get the index of an input file, checking
+        // that it did not change since the checkpoint
+        std::size_t getInput(const std::string& path) {
+            const auto size = std::filesystem::file_size(path);
+            const std::int64_t modified =
+                std::filesystem::last_write_time(path).time_since_epoch().count();
+
+            auto it = std::ranges::find(m_inputs, path, &Input::path);
+            if (it == m_inputs.end()) {
+                m_inputs.push_back({path, size, modified, 0});
+                return m_inputs.size() - 1;
+            }
+            if (it->size != size || it->modified != modified) {
+                throw std::invalid_argument("Input changed since the checkpoint: " + path);
+            }
+            return it - m_inputs.begin();
+        }
+
+        // One input per line: path, size, modification
+        // time and number of processed events
+        static std::string formatInputs(const std::vector<Input>& inputs) {
+            std::ostringstream out;
+            for (const auto& input : inputs) {
+                out << input.path << '\t' << input.size << '\t'
+                    << input.modified << '\t' << input.nProcessed << '\n';
+            }
+            return out.str();
+        }
+
+        static std::vector<Input> parseInputs(const std::string& text) {
+            std::vector<Input> inputs;
+            std::istringstream in(text);
+            std::string line;
+            while (std::getline(in, line)) {
+                std::istringstream fields(line);
+                Input input;
+                if (!std::getline(fields, input.path, '\t') ||
+                    !(fields >> input.size >> input.modified >> input.nProcessed)) {
+                        throw std::invalid_argument("Invalid processed input: " + line);
+                }
+                inputs.push_back(input);
+            }
+            return inputs;
+        }
+};
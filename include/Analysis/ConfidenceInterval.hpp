@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cmath>
+#include <utility>
+
+#include "TEfficiency.h"
+
+// Method of the efficiency confidence intervals
+enum class IntervalMethod {
+    /// Bounds where the binomial log-likelihood
+    /// drops by 0.5 from its maximum
+    ProfileLikelihood,
+    /// Wilson score interval
+    Wilson,
+    /// Exact Clopper-Pearson interval
+    ClopperPearson
+};
+
+namespace ConfidenceInterval {
+    /// Coverage of the one sigma interval, same as
+    /// the likelihood drop of 0.5
+    inline constexpr double oneSigma = 0.682689492137086;
+
+    // Find the root of a function changing sign
+    // on [low, high] by bisection
+    //
+    // @par f: function with f(low) and f(high)
+    // of opposite sign
+    // @par tolerance: width of the final bracket
+    template <typename F>
+    double findRoot(F&& f, double low, double high, double tolerance = 1e-10) {
+        const bool lowNegative = f(low) < 0;
+        while (high - low > tolerance) {
+            const double mid = 0.5 * (low + high);
+            if ((f(mid) < 0) == lowNegative) {
+                low = mid;
+            }
+            else {
+                high = mid;
+            }
+        }
+        return 0.5 * (low + high);
+    }
+
+    // Profile likelihood interval of an efficiency
+    //
+    // Solves logL(q) = logL(p) - 0.5 on both sides of
+    // the estimate, the former stepping search found
+    // the same bounds rounded outwards to 1e-4. As
+    // before, efficiencies of 0 or 1 get no errors.
+    //
+    // @return: lower and upper error
+    inline std::pair<double, double> profileLikelihood(double accept, double reject) {
+        if (accept <= 0 || reject <= 0) {
+            return {0, 0};
+        }
+        const double p = accept / (accept + reject);
+        const double lMax = accept * std::log(p) + reject * std::log(1 - p);
+        auto drop = [&] (double q) {
+            return accept * std::log(q) + reject * std::log(1 - q) - lMax + 0.5;
+        };
+
+        // The drop diverges at q = 0 and q = 1
+        const double lower = findRoot(drop, 0, p);
+        const double upper = findRoot(drop, p, 1);
+        return {p - lower, upper - p};
+    }
+
+    // Confidence interval of an efficiency
+    //
+    // @par accept: number of accepted events
+    // @par reject: number of rejected events
+    // @par method: method of the interval
+    //
+    // @return: lower and upper error with
+    // respect to accept / (accept + reject)
+    inline std::pair<double, double> errors(
+        double accept,
+        double reject,
+        IntervalMethod method = IntervalMethod::ProfileLikelihood) {
+            const double total = accept + reject;
+            if (total <= 0) {
+                return {0, 0};
+            }
+            const double p = accept / total;
+            switch (method) {
+                case IntervalMethod::Wilson:
+                    return {
+                        p - TEfficiency::Wilson(total, accept, oneSigma, false),
+                        TEfficiency::Wilson(total, accept, oneSigma, true) - p};
+                case IntervalMethod::ClopperPearson:
+                    return {
+                        p - TEfficiency::ClopperPearson(total, accept, oneSigma, false),
+                        TEfficiency::ClopperPearson(total, accept, oneSigma, true) - p};
+                default:
+                    return profileLikelihood(accept, reject);
+            }
+    }
+} // namespace ConfidenceInterval
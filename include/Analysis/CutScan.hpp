@@ -0,0 +1,482 @@
+#pragma once
+
+#include "include/Types/Track.hpp"
+#include "include/Types/EventTracks.hpp"
+#include "include/Analysis/BatchCuts.hpp"
+#include "include/Analysis/ConfidenceInterval.hpp"
+#include "include/Analysis/Cuts.hpp"
+#include "include/Analysis/EventStats.hpp"
+#include "include/Analysis/HourglassFilter.hpp"
+#include "include/Analysis/OverlapResolver.hpp"
+#include "include/Analysis/TrackHistogramSet.hpp"
+#include "include/Analysis/UnitRegistry.hpp"
+#include "include/detail/HelperFunctions.hpp"
+#include "include/detail/Profiler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "TFile.h"
+#include "TVectorD.h"
+
+// Axis of a cut-threshold scan
+struct ScanAxis {
+    // Bound of the cut range that is scanned
+    enum class Bound {
+        Lower,
+        Upper
+    };
+
+    /// Name of the scanned cut
+    std::string cut;
+
+    /// Scanned bound, the other one
+    /// keeps the value of the cut
+    Bound bound = Bound::Upper;
+
+    /// Values of the bound, ascending
+    std::vector<double> thresholds;
+
+    // Parse an axis of the form cut:lower|upper:t1,t2,...
+    static ScanAxis parse(const std::string& spec) {
+        const std::string format = "Scan axis must be given as cut:lower|upper:t1,t2,...: ";
+        auto first = spec.find(':');
+        auto second = spec.find(':', first == std::string::npos ? first : first + 1);
+        if (second == std::string::npos) {
+            throw std::invalid_argument(format + spec);
+        }
+        ScanAxis axis;
+        axis.cut = spec.substr(0, first);
+
+        const std::string bound = spec.substr(first + 1, second - first - 1);
+        if (bound == "lower") {
+            axis.bound = Bound::Lower;
+        }
+        else if (bound == "upper") {
+            axis.bound = Bound::Upper;
+        }
+        else {
+            throw std::invalid_argument(format + spec);
+        }
+
+        std::size_t begin = second + 1;
+        while (begin <= spec.size()) {
+            auto end = std::min(spec.find(',', begin), spec.size());
+            try {
+                axis.thresholds.push_back(std::stod(spec.substr(begin, end - begin)));
+            }
+            catch (const std::logic_error&) {
+                throw std::invalid_argument(format + spec);
+            }
+            begin = end + 1;
+        }
+        return axis;
+    }
+};
+
+// Single-pass scan of the thresholds of one or two cuts
+//
+// The passing grid points of a scanned cut always form
+// a contiguous run of thresholds ending at the loosest
+// one. Every track passing the other cuts is therefore
+// filled once, into the cell of its tightest passing
+// threshold, and the histograms of a grid point are the
+// sum of the cells up to it, built when storing. Only
+// the cut flows are counted per grid point, as they
+// depend on the cut order.
+class ScanEngine {
+    public:
+        // Per-matching-degree scan state
+        struct DegreeState {
+            /// Cuts with the matching degree
+            /// cut fixed to this degree
+            Cuts cuts;
+
+            /// Histograms of the tracks whose tightest
+            /// passing grid point is the cell
+            std::vector<TrackHistogramSet> cells;
+
+            /// Cut flows of every grid point
+            std::vector<CutFlowSummary> cutFlows;
+
+            /// Cut flows of the current event, the part
+            /// shared by all grid points counted once
+            std::vector<CutFlow> eventFlows;
+            CutFlow commonFlow;
+        };
+
+        /// Maximal number of grid points, every worker
+        /// holds a histogram set per grid point and 
+        /// matching degree
+        static constexpr std::size_t maxPoints = 256;
+
+        ScanEngine(const Cuts& cuts, const std::vector<ScanAxis>& axes) :
+            m_cuts(cuts),
+            m_axes(axes),
+            m_overlapResolver(cuts.overlaps),
+            m_static(UnitRegistry::matches(units) && UnitRegistry::matches(cuts)) {
+                if (axes.empty() || axes.size() > 2) {
+                    throw std::invalid_argument("A scan has one or two axes");
+                }
+                for (const auto& axis : axes) {
+                    auto it = std::ranges::find(m_cuts.cuts, axis.cut, &Cut::name);
+                    if (it == m_cuts.cuts.end()) {
+                        throw std::invalid_argument("Unknown scanned cut " + axis.cut);
+                    }
+                    if (it == m_cuts.cuts.begin()) {
+                        throw std::invalid_argument("The matching degree cannot be scanned");
+                    }
+                    if (axis.thresholds.empty() ||
+                        !std::ranges::is_sorted(axis.thresholds)) {
+                            throw std::invalid_argument(
+                                "Thresholds of " + axis.cut + " must be ascending");
+                    }
+                    m_axisCuts.push_back(it - m_cuts.cuts.begin());
+                }
+                if (axes.size() == 2 && m_axisCuts[0] == m_axisCuts[1]) {
+                    throw std::invalid_argument("Both axes scan " + axes[0].cut);
+                }
+                if (nPoints() > maxPoints) {
+                    throw std::invalid_argument(
+                        "Scan of " + std::to_string(nPoints()) + " grid points exceeds " +
+                        std::to_string(maxPoints) + ", use fewer thresholds");
+                }
+                if (cuts.hourglass.has_value()) {
+                    m_hourglass.emplace(cuts.hourglass.value());
+                }
+        }
+
+        // Number of grid points
+        std::size_t nPoints() const {
+            std::size_t n = 1;
+            for (const auto& axis : m_axes) {
+                n *= axis.thresholds.size();
+            }
+            return n;
+        }
+
+        // Process the tracks of a single event
+        //
+        // @par eventId: id of the event
+        // @par tracks: tracks of the event
+        void processEvent(std::uint32_t eventId, EventTracks& tracks) {
+            Profiler::addEvent();
+
+            if (!tracks.hasStoredFlags) {
+                {
+                    ScopedTimer timer(Stage::RemoveOverlaps);
+                    m_overlapResolver.resolve(tracks);
+                }
+                ScopedTimer timer(Stage::RemoveMultiple);
+                removeMultiple(tracks);
+            }
+
+            m_nEvents++;
+
+            // Cuts and the filling of the grid cells
+            // are interleaved, both count as cuts
+            ScopedTimer timer(Stage::Cuts);
+
+            const auto& masks = m_batchCuts.evaluate(tracks, m_cuts, m_static);
+            const auto nCuts = m_cuts.cuts.size();
+            if (m_hourglass.has_value()) {
+                m_hourglass->count(tracks.trackHits, tracks.size());
+            }
+
+            CutMask scanned = 0;
+            for (auto k : m_axisCuts) {
+                scanned = BatchCuts::setCut(scanned, k, true);
+            }
+
+            m_eventDegrees.clear();
+            for (auto i : tracks.order) {
+                if (m_hourglass.has_value() && !m_hourglass->passes(i)) {
+                    continue;
+                }
+                const TrackView track = tracks.view(i);
+
+                auto& degree = getDegreeState(track.matchingDegree);
+                if (std::ranges::find(m_eventDegrees, &degree) == m_eventDegrees.end()) {
+                    m_eventDegrees.push_back(&degree);
+                }
+
+                const auto& degreeCut = degree.cuts.cuts.front();
+                const double value = degreeCut.getter(track);
+                const auto mask = BatchCuts::setCut(masks[i], 0,
+                    !(degreeCut.range.first > value || degreeCut.range.second < value));
+
+                // Passing thresholds of every axis
+                std::array<std::pair<std::size_t, std::size_t>, 2> runs = {{{0, 1}, {0, 1}}};
+                for (std::size_t a = 0; a < m_axes.size(); a++) {
+                    runs[a] = passingRun(a, m_cuts.cuts[m_axisCuts[a]].getter(track));
+                }
+
+                // Cuts before the first failed or scanned
+                // cut are passed at every grid point
+                const auto nCommon = BatchCuts::nPassed(mask & ~scanned);
+                for (std::size_t k = 0; k < nCommon && k < nCuts; k++) {
+                    degree.commonFlow.flow[k]++;
+                }
+                if (nCommon < nCuts && BatchCuts::setCut(0, nCommon, true) & scanned) {
+                    const std::size_t n2 = m_axes.size() > 1 ? m_axes[1].thresholds.size() : 1;
+                    for (std::size_t p = 0; p < degree.eventFlows.size(); p++) {
+                        const std::size_t g1 = p / n2;
+                        const std::size_t g2 = p % n2;
+                        CutMask pointMask = mask & ~scanned;
+                        pointMask = BatchCuts::setCut(pointMask, m_axisCuts[0],
+                            runs[0].first <= g1 && g1 < runs[0].second);
+                        if (m_axes.size() > 1) {
+                            pointMask = BatchCuts::setCut(pointMask, m_axisCuts[1],
+                                runs[1].first <= g2 && g2 < runs[1].second);
+                        }
+                        const auto nPassed = BatchCuts::nPassed(pointMask);
+                        for (std::size_t k = nCommon; k < nPassed && k < nCuts; k++) {
+                            degree.eventFlows[p].flow[k]++;
+                        }
+                    }
+                }
+
+                // Fill the cell of the tightest passing
+                // threshold of the tracks passing the rest
+                if (!BatchCuts::passes(mask | scanned, nCuts)) {
+                    continue;
+                }
+                std::size_t cell = 0;
+                bool passesAny = true;
+                for (std::size_t a = 0; a < m_axes.size(); a++) {
+                    const auto [first, last] = runs[a];
+                    passesAny = passesAny && first < last;
+                    const std::size_t tightest =
+                        m_axes[a].bound == ScanAxis::Bound::Upper ? first : last - 1;
+                    cell = cell * m_axes[a].thresholds.size() + tightest;
+                }
+                if (!passesAny) {
+                    continue;
+                }
+                if (m_static) {
+                    degree.cells[cell].fillStatic(track);
+                }
+                else {
+                    degree.cells[cell].fill(track);
+                }
+            }
+
+            for (auto* degree : m_eventDegrees) {
+                for (std::size_t p = 0; p < degree->eventFlows.size(); p++) {
+                    auto& flow = degree->eventFlows[p].flow;
+                    for (std::size_t k = 0; k < flow.size(); k++) {
+                        flow[k] += degree->commonFlow.flow[k];
+                    }
+                    degree->cutFlows[p].add(degree->eventFlows[p]);
+                    std::ranges::fill(flow, 0);
+                }
+                std::ranges::fill(degree->commonFlow.flow, 0);
+            }
+        }
+
+        // Merge the results of an engine that
+        // processed a different set of events
+        void merge(const ScanEngine& other) {
+            for (const auto& [matchingDegree, otherDegree] : other.m_degrees) {
+                auto& degree = getDegreeState(matchingDegree);
+                for (std::size_t p = 0; p < degree.cells.size(); p++) {
+                    degree.cells[p].add(otherDegree.cells[p]);
+                    degree.cutFlows[p].add(otherDegree.cutFlows[p]);
+                }
+            }
+            m_nEvents += other.m_nEvents;
+        }
+
+        // Count events without any tracks, e.g. the
+        // events of the input that are absent from a skim
+        void addEmptyEvents(std::size_t nEvents) {
+            m_nEvents += nEvents;
+        }
+
+        // Clear the results, keeping the histograms
+        // of the seen degrees for the next events
+        void reset() {
+            for (auto& [matchingDegree, degree] : m_degrees) {
+                for (std::size_t p = 0; p < degree.cells.size(); p++) {
+                    degree.cells[p].reset();
+                    degree.cutFlows[p].reset();
+                }
+            }
+            m_nEvents = 0;
+        }
+
+        // Write the histograms and cut flows of every
+        // grid point of every matching degree, and the
+        // thresholds of the axes indexed as the names
+        // of the grid points
+        void store(
+            TFile* outFile,
+            IntervalMethod method = IntervalMethod::ProfileLikelihood) const {
+                ScopedTimer timer(Stage::Write);
+                outFile->cd();
+                for (const auto& axis : m_axes) {
+                    TVectorD thresholds(axis.thresholds.size());
+                    for (std::size_t g = 0; g < axis.thresholds.size(); g++) {
+                        thresholds[g] = axis.thresholds[g];
+                    }
+                    thresholds.Write(("scanThresholds_" + axis.cut).c_str());
+                }
+
+                for (const auto& [matchingDegree, degree] : m_degrees) {
+                    const auto points = pointHistograms(degree);
+                    for (std::size_t p = 0; p < points.size(); p++) {
+                        storeTrackHistograms(outFile, points[p]);
+
+                        CutFlowSummary summary = degree.cutFlows[p];
+                        summary.nEvents = m_nEvents;
+                        auto [cutFlow, cutFlowErrs] =
+                            getCutFlow(summary, points[p].suffix(), -1, method);
+                        cutFlow->Write();
+                        cutFlowErrs->Write();
+                    }
+                }
+        }
+
+        // Histograms of every grid point of a degree,
+        // the sums of the cells up to the grid point
+        std::vector<TrackHistogramSet> pointHistograms(const DegreeState& degree) const {
+            auto points = degree.cells;
+            std::size_t stride = points.size();
+            for (const auto& axis : m_axes) {
+                const std::size_t n = axis.thresholds.size();
+                stride /= n;
+                accumulate(points, n, stride, axis.bound);
+            }
+            return points;
+        }
+
+        // Number of processed events
+        std::size_t nEvents() const {
+            return m_nEvents;
+        }
+
+        const std::map<double, DegreeState>& degrees() const {
+            return m_degrees;
+        }
+
+    private:
+        Cuts m_cuts;
+
+        std::vector<ScanAxis> m_axes;
+
+        // Index of the scanned cut of every axis
+        std::vector<std::size_t> m_axisCuts;
+
+        OverlapResolver m_overlapResolver;
+
+        // Units and cuts match the registry and
+        // the getters are dispatched statically
+        bool m_static;
+
+        BatchCuts m_batchCuts;
+
+        std::optional<HourglassCounter> m_hourglass;
+
+        std::map<double, DegreeState> m_degrees;
+
+        std::size_t m_nEvents = 0;
+
+        // Degrees with tracks in the current event
+        std::vector<DegreeState*> m_eventDegrees;
+
+        // Grid points of an axis a value passes, as
+        // the run [first, last) of threshold indices
+        std::pair<std::size_t, std::size_t> passingRun(std::size_t a, double value) const {
+            const auto& axis = m_axes[a];
+            const auto& range = m_cuts.cuts[m_axisCuts[a]].range;
+            const auto& thresholds = axis.thresholds;
+            const std::size_t n = thresholds.size();
+
+            // NaN passes every range
+            if (std::isnan(value)) {
+                return {0, n};
+            }
+            if (axis.bound == ScanAxis::Bound::Upper) {
+                if (range.first > value) {
+                    return {0, 0};
+                }
+                const std::size_t first =
+                    std::ranges::lower_bound(thresholds, value) - thresholds.begin();
+                return {first, n};
+            }
+            if (range.second < value) {
+                return {0, 0};
+            }
+            const std::size_t last =
+                std::ranges::upper_bound(thresholds, value) - thresholds.begin();
+            return {0, last};
+        }
+
+        // Turn the cells into cumulative sums along one axis,
+        // towards the looser thresholds
+        //
+        // @par n: number of thresholds of the axis
+        // @par stride: distance of neighbouring thresholds
+        static void accumulate(
+            std::vector<TrackHistogramSet>& points,
+            std::size_t n,
+            std::size_t stride,
+            ScanAxis::Bound bound) {
+                const std::size_t nPoints = points.size();
+                for (std::size_t p = 0; p < nPoints; p++) {
+                    const std::size_t g = (p / stride) % n;
+                    if (bound == ScanAxis::Bound::Upper && g > 0) {
+                        points[p].add(points[p - stride]);
+                    }
+                }
+                if (bound == ScanAxis::Bound::Lower) {
+                    for (std::size_t p = nPoints; p-- > 0;) {
+                        const std::size_t g = (p / stride) % n;
+                        if (g + 1 < n) {
+                            points[p].add(points[p + stride]);
+                        }
+                    }
+                }
+        }
+
+        // Name suffix of a grid point, with the threshold
+        // index of every axis into scanThresholds_<cut>
+        std::string pointSuffix(double matchingDegree, std::size_t p) const {
+            std::string suffix = std::to_string(matchingDegree);
+            std::size_t stride = nPoints();
+            for (const auto& axis : m_axes) {
+                stride /= axis.thresholds.size();
+                const std::size_t g = (p / stride) % axis.thresholds.size();
+                suffix += "_" + axis.cut + "_" + std::to_string(g);
+            }
+            return suffix;
+        }
+
+        // Get the state of the matching degree,
+        // creating it on first encounter
+        DegreeState& getDegreeState(double matchingDegree) {
+            auto it = m_degrees.find(matchingDegree);
+            if (it != m_degrees.end()) {
+                return it->second;
+            }
+            Cuts cuts = m_cuts;
+            cuts.cuts.at(0).range = {matchingDegree, matchingDegree};
+
+            DegreeState degree{cuts, {}, {}, {}, CutFlow(cuts.cuts.size())};
+            for (std::size_t p = 0; p < nPoints(); p++) {
+                degree.cells.emplace_back(pointSuffix(matchingDegree, p));
+                degree.cutFlows.emplace_back(cuts.cuts.size());
+                degree.eventFlows.emplace_back(cuts.cuts.size());
+            }
+            return m_degrees.emplace(matchingDegree, std::move(degree)).first->second;
+        }
+};
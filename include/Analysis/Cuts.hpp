@@ -1,10 +1,16 @@
 #pragma once
 
 #include "include/Analysis/AnalysisUnit.hpp"
+#include "include/Analysis/HourglassFilter.hpp"
+#include "include/Analysis/OverlapResolver.hpp"
 #include "include/Types/Track.hpp"
 
-#include <map>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <utility>
+#include <vector>
 
 struct Cut {
     std::string name;
@@ -17,6 +23,14 @@ struct Cut {
 struct Cuts {
     std::vector<Cut> cuts;
 
+    /// Definition of the overlaps rejected
+    /// by the isOverlap cut
+    OverlapConfig overlaps;
+
+    /// Hourglass pre-filter on the hits of the tracks,
+    /// rejected tracks do not enter the cut flow
+    std::optional<HourglassCut> hourglass;
+
     Cuts() {
         for (auto unit : units) {
             if (unit.range.has_value()) {
@@ -27,12 +41,16 @@ struct Cuts {
     }
 };
 
+// Number of cuts defined by the units
+inline std::size_t nCuts() {
+    return std::ranges::count_if(units, 
+        [] (const auto& unit) { return unit.range.has_value(); });
+}
+
+// Number of tracks of an event passing each
+// cut, indexed as the cuts
 struct CutFlow {
-    std::map<std::string, double> flow;
+    std::vector<std::uint32_t> flow;
     
-    CutFlow() {
-        for (auto unit : units) {
-            flow[unit.name] = 0;
-        }
-    }
+    CutFlow(std::size_t n = nCuts()) : flow(n, 0) {}
 };
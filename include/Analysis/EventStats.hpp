@@ -2,7 +2,55 @@
 
 #include "include/Analysis/Cuts.hpp" 
 
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
 struct EventStats {
     // Cut flow
     CutFlow cutFlow;
 };
+
+// Cut flow of a set of events reduced to the 
+// counts needed for the averages and the 
+// confidence intervals, mergeable across shards
+struct CutFlowSummary {
+    /// Sum of the cut flow over the events,
+    /// indexed as the cuts
+    std::vector<double> sum;
+
+    /// Number of events with a non-zero cut flow
+    std::vector<double> accept;
+
+    /// Number of events
+    double nEvents = 0;
+
+    CutFlowSummary(std::size_t n = nCuts()) : 
+        sum(n, 0), 
+        accept(n, 0) {}
+
+    // Add the cut flow of an event
+    void add(const CutFlow& cutFlow) {
+        for (std::size_t k = 0; k < cutFlow.flow.size(); k++) {
+            sum.at(k) += cutFlow.flow[k];
+            accept.at(k) += cutFlow.flow[k] != 0;
+        }
+        nEvents++;
+    }
+
+    // Add the summary of a disjoint set of events
+    void add(const CutFlowSummary& other) {
+        for (std::size_t k = 0; k < other.sum.size(); k++) {
+            sum.at(k) += other.sum[k];
+            accept.at(k) += other.accept[k];
+        }
+        nEvents += other.nEvents;
+    }
+
+    // Clear the counts, keeping the number of cuts
+    void reset() {
+        std::fill(sum.begin(), sum.end(), 0);
+        std::fill(accept.begin(), accept.end(), 0);
+        nEvents = 0;
+    }
+};
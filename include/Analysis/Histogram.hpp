@@ -0,0 +1,230 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "TH1.h"
+
+// Fixed-binning histogram of plain bin arrays
+//
+// Bins, under/overflow and statistics follow TH1D
+// filled with unit weights, so the TH1D built by
+// toTH1D is the same as one filled directly. Every
+// thread fills its own histogram and they are added
+// at the end.
+class Histogram {
+    public:
+        Histogram(std::string name, int nBins, double low, double high) :
+            m_name(std::move(name)),
+            m_nBins(checkBinning(m_name, nBins, low, high)),
+            m_low(low),
+            m_high(high),
+            m_bins(new double[nBins + 2]()) {}
+
+        Histogram(const Histogram& other) :
+            Histogram(other.m_name, other.m_nBins, other.m_low, other.m_high) {
+                add(other);
+        }
+
+        Histogram& operator=(const Histogram& other) {
+            if (this != &other) {
+                Histogram copy(other);
+                swap(copy);
+            }
+            return *this;
+        }
+
+        Histogram(Histogram&&) = default;
+        Histogram& operator=(Histogram&&) = default;
+
+        const std::string& name() const {
+            return m_name;
+        }
+
+        int nBins() const {
+            return m_nBins;
+        }
+
+        // Bin of a value, 0 for underflow and
+        // nBins + 1 for overflow and NaN
+        //
+        // Same arithmetic as TAxis::FindFixBin, a
+        // multiplication by the inverse bin width
+        // would move values at the bin edges
+        int findBin(double x) const {
+            if (x < m_low) {
+                return 0;
+            }
+            if (!(x < m_high)) {
+                return m_nBins + 1;
+            }
+            return 1 + int(m_nBins * (x - m_low) / (m_high - m_low));
+        }
+
+        // Fill a value with unit weight
+        void fill(double x) {
+            const int bin = findBin(x);
+            m_bins[bin] += 1;
+            m_entries += 1;
+
+            // Under/overflow does not enter the
+            // statistics, same as TH1 by default
+            if (bin > 0 && bin <= m_nBins) {
+                m_sumw += 1;
+                m_sumw2 += 1;
+                m_sumwx += x;
+                m_sumwx2 += x * x;
+            }
+        }
+
+        // Fill a batch of values
+        void fill(std::span<const double> xs) {
+            // Accumulate in the same order as
+            // single fills, keeping the sums exact
+            double entries = m_entries;
+            double sumw = m_sumw;
+            double sumwx = m_sumwx;
+            double sumwx2 = m_sumwx2;
+            for (double x : xs) {
+                const int bin = findBin(x);
+                m_bins[bin] += 1;
+                entries += 1;
+                if (bin > 0 && bin <= m_nBins) {
+                    sumw += 1;
+                    sumwx += x;
+                    sumwx2 += x * x;
+                }
+            }
+            m_sumw2 += sumw - m_sumw;
+            m_entries = entries;
+            m_sumw = sumw;
+            m_sumwx = sumwx;
+            m_sumwx2 = sumwx2;
+        }
+
+        // Clear the contents and statistics,
+        // keeping the binning and the bins
+        void reset() {
+            for (int bin = 0; bin < m_nBins + 2; bin++) {
+                m_bins[bin] = 0;
+            }
+            m_entries = 0;
+            m_sumw = 0;
+            m_sumw2 = 0;
+            m_sumwx = 0;
+            m_sumwx2 = 0;
+        }
+
+        // Content of a bin, including under/overflow
+        double content(int bin) const {
+            return m_bins[bin];
+        }
+
+        double entries() const {
+            return m_entries;
+        }
+
+        // Add a histogram with the same binning
+        void add(const Histogram& other) {
+            if (other.nBins() != m_nBins) {
+                throw std::invalid_argument("Binning mismatch adding to " + m_name);
+            }
+            for (int bin = 0; bin < m_nBins + 2; bin++) {
+                m_bins[bin] += other.content(bin);
+            }
+            double stats[4];
+            other.getStats(stats);
+            m_sumw += stats[0];
+            m_sumw2 += stats[1];
+            m_sumwx += stats[2];
+            m_sumwx2 += stats[3];
+            m_entries += other.entries();
+        }
+
+        // Add the contents of a TH1D with the same binning
+        void add(const TH1& hist) {
+            if (hist.GetNbinsX() != m_nBins) {
+                throw std::invalid_argument("Binning mismatch adding to " + m_name);
+            }
+            for (int bin = 0; bin < m_nBins + 2; bin++) {
+                m_bins[bin] += hist.GetBinContent(bin);
+            }
+            double stats[4];
+            hist.GetStats(stats);
+            m_sumw += stats[0];
+            m_sumw2 += stats[1];
+            m_sumwx += stats[2];
+            m_sumwx2 += stats[3];
+            m_entries += hist.GetEntries();
+        }
+
+        // Sum of weights, of squared weights, of
+        // weighted values and of weighted squares,
+        // in the layout of TH1::GetStats
+        void getStats(double* stats) const {
+            stats[0] = m_sumw;
+            stats[1] = m_sumw2;
+            stats[2] = m_sumwx;
+            stats[3] = m_sumwx2;
+        }
+
+        // Convert to a TH1D owned by the caller
+        // and not attached to any directory
+        TH1D* toTH1D() const {
+            TH1D* hist = new TH1D(m_name.c_str(), "", m_nBins, m_low, m_high);
+            hist->SetDirectory(nullptr);
+            for (int bin = 0; bin < m_nBins + 2; bin++) {
+                hist->SetBinContent(bin, m_bins[bin]);
+            }
+            double stats[4];
+            getStats(stats);
+            hist->PutStats(stats);
+            hist->SetEntries(m_entries);
+            return hist;
+        }
+
+        void swap(Histogram& other) {
+            std::swap(m_name, other.m_name);
+            std::swap(m_nBins, other.m_nBins);
+            std::swap(m_low, other.m_low);
+            std::swap(m_high, other.m_high);
+            std::swap(m_bins, other.m_bins);
+            std::swap(m_entries, other.m_entries);
+            std::swap(m_sumw, other.m_sumw);
+            std::swap(m_sumw2, other.m_sumw2);
+            std::swap(m_sumwx, other.m_sumwx);
+            std::swap(m_sumwx2, other.m_sumwx2);
+        }
+
+    private:
+        std::string m_name;
+        int m_nBins;
+        double m_low;
+        double m_high;
+
+        /// Bin contents, with underflow at 0
+        /// and overflow at nBins + 1
+        std::unique_ptr<double[]> m_bins;
+
+        /// Number of fills and in-range statistics
+        double m_entries = 0;
+        double m_sumw = 0;
+        double m_sumw2 = 0;
+        double m_sumwx = 0;
+        double m_sumwx2 = 0;
+
+        // Validate the binning before the bins are allocated
+        //
+        // @return: the number of bins
+        static int checkBinning(const std::string& name, int nBins, double low, double high) {
+            if (nBins <= 0 || !(low < high)) {
+                throw std::invalid_argument("Invalid binning of " + name);
+            }
+            return nBins;
+        }
+};
+
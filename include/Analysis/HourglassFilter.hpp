@@ -1,5 +1,17 @@
 #pragma once
 
+#include "include/Types/EventTracks.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
 // Filter that classifies clusters as signal or background
 // based on their position in the x-y plane
 struct HourglassFilter {
@@ -51,4 +63,264 @@ struct HourglassFilter {
             return cond0;
         }
     }
+
+    // Classify a batch of points
+    //
+    // Both sides and the tunnel are evaluated for every
+    // point and combined with bitwise operations, so the
+    // loop has no branches and the compiler can vectorize
+    // it. Gives the same result as the single-point filter.
+    //
+    // @par xs: x-coordinates of the points
+    // @par ys: y-coordinates of the points
+    // @par inside: set to 1 for the points inside
+    // the hourglass shape, 0 otherwise
+    void operator()(
+        std::span<const double> xs,
+        std::span<const double> ys,
+        std::span<std::uint8_t> inside) const {
+            if (xs.size() != ys.size() || xs.size() != inside.size()) {
+                throw std::invalid_argument("Mismatched sizes of the hourglass batch");
+            }
+            const std::size_t n = xs.size();
+            const double* x = xs.data();
+            const double* y = ys.data();
+            std::uint8_t* out = inside.data();
+
+            // Byte stores may alias the parameters,
+            // which would be reloaded on every point
+            const double slope1 = a1;
+            const double slope2 = a2;
+            const double shift0 = b0;
+            const double shift1 = b1;
+            const double shift2 = b2;
+            const double halfTunnel = tunnel;
+            for (std::size_t i = 0; i < n; i++) {
+                const double line1 = slope1 * x[i];
+                const double line2 = slope2 * x[i];
+
+                const bool negative = x[i] < 0;
+                const bool cond0 =
+                    (negative & (y[i] < line1 + shift0)) | (!negative & (y[i] < line2 + shift0));
+
+                const bool left = x[i] < -halfTunnel;
+                const bool right = x[i] > halfTunnel;
+                const bool leftSide = (y[i] < line1 + shift1) | (y[i] > line2 + shift2);
+                const bool rightSide = (y[i] > line1 + shift1) | (y[i] < line2 + shift2);
+
+                out[i] = cond0 &
+                    ((left & leftSide) | (right & rightSide) | (!left & !right));
+            }
+    }
+};
+
+// Lookup grid of the hourglass classification
+// for fixed filter parameters
+//
+// A cell that none of the hourglass lines and
+// x-boundaries cross has a single classification,
+// which is stored. Points in crossed cells or
+// outside the grid fall back to the exact filter.
+class HourglassGrid {
+    public:
+        struct Binning {
+            double xMin = -100;
+            double xMax = 100;
+            double yMin = -100;
+            double yMax = 300;
+            int nX = 256;
+            int nY = 256;
+        };
+
+        HourglassGrid(const HourglassFilter& filter, const Binning& binning) :
+            m_filter(filter),
+            m_binning(binning) {
+                if (binning.nX <= 0 || binning.nY <= 0 ||
+                    !(binning.xMin < binning.xMax) || !(binning.yMin < binning.yMax)) {
+                        throw std::invalid_argument("Invalid binning of the hourglass grid");
+                }
+                m_invWidthX = binning.nX / (binning.xMax - binning.xMin);
+                m_invWidthY = binning.nY / (binning.yMax - binning.yMin);
+
+                m_cells.resize(std::size_t(binning.nX) * binning.nY);
+                for (int ix = 0; ix < binning.nX; ix++) {
+                    for (int iy = 0; iy < binning.nY; iy++) {
+                        m_cells[std::size_t(ix) * binning.nY + iy] = classifyCell(ix, iy);
+                    }
+                }
+        }
+
+        const HourglassFilter& filter() const {
+            return m_filter;
+        }
+
+        // Classify a batch of points, same
+        // interface and result as the filter
+        void operator()(
+            std::span<const double> xs,
+            std::span<const double> ys,
+            std::span<std::uint8_t> inside) const {
+                if (xs.size() != ys.size() || xs.size() != inside.size()) {
+                    throw std::invalid_argument("Mismatched sizes of the hourglass batch");
+                }
+                const std::size_t n = xs.size();
+                const double* x = xs.data();
+                const double* y = ys.data();
+                std::uint8_t* out = inside.data();
+                const auto [xMin, xMax, yMin, yMax, nX, nY] = m_binning;
+                const double invWidthX = m_invWidthX;
+                const double invWidthY = m_invWidthY;
+                const std::uint8_t* cells = m_cells.data();
+
+                // Branch-free lookup, points outside the
+                // grid, NaN included, read as crossed
+                for (std::size_t i = 0; i < n; i++) {
+                    const bool inGrid =
+                        (x[i] >= xMin) & (x[i] < xMax) & (y[i] >= yMin) & (y[i] < yMax);
+                    const double px = inGrid ? x[i] : xMin;
+                    const double py = inGrid ? y[i] : yMin;
+                    const int ix = std::min(int((px - xMin) * invWidthX), nX - 1);
+                    const int iy = std::min(int((py - yMin) * invWidthY), nY - 1);
+                    const std::uint8_t cell = cells[std::size_t(ix) * nY + iy];
+                    out[i] = inGrid ? cell : crossed;
+                }
+
+                for (std::size_t i = 0; i < n; i++) {
+                    if (out[i] == crossed) {
+                        out[i] = m_filter(x[i], y[i]);
+                    }
+                }
+        }
+
+    private:
+        static constexpr std::uint8_t crossed = 2;
+
+        HourglassFilter m_filter;
+        Binning m_binning;
+
+        double m_invWidthX;
+        double m_invWidthY;
+
+        /// Classification of the cells, 0 outside,
+        /// 1 inside and crossed for mixed cells
+        std::vector<std::uint8_t> m_cells;
+
+        // Classification of a cell, widened by a fraction
+        // of its size to absorb the rounding of the lookup
+        std::uint8_t classifyCell(int ix, int iy) const {
+            const double widthX = 1 / m_invWidthX;
+            const double widthY = 1 / m_invWidthY;
+            const double x0 = m_binning.xMin + ix * widthX - 1e-6 * widthX;
+            const double x1 = m_binning.xMin + (ix + 1) * widthX + 1e-6 * widthX;
+            const double y0 = m_binning.yMin + iy * widthY - 1e-6 * widthY;
+            const double y1 = m_binning.yMin + (iy + 1) * widthY + 1e-6 * widthY;
+
+            const auto& f = m_filter;
+            for (double edge : {0.0, -f.tunnel, f.tunnel}) {
+                if (x0 <= edge && edge <= x1) {
+                    return crossed;
+                }
+            }
+
+            // A line misses the cell if all corners lie
+            // strictly on the same side of it
+            const std::array<std::array<double, 2>, 4> lines = {{
+                {f.a1, f.b0}, {f.a2, f.b0}, {f.a1, f.b1}, {f.a2, f.b2}}};
+            for (const auto& [a, b] : lines) {
+                int above = 0;
+                int below = 0;
+                for (double x : {x0, x1}) {
+                    for (double y : {y0, y1}) {
+                        const double distance = y - (a * x + b);
+                        const double margin = 1e-9 * (1 + std::abs(y) + std::abs(a * x) + std::abs(b));
+                        above += distance > margin;
+                        below += distance < -margin;
+                    }
+                }
+                if (above != 4 && below != 4) {
+                    return crossed;
+                }
+            }
+            return m_filter(0.5 * (x0 + x1), 0.5 * (y0 + y1));
+        }
+};
+
+// Hourglass filter applied to the hits of the tracks
+struct HourglassCut {
+    HourglassFilter filter;
+
+    /// Maximal number of hits outside the
+    /// hourglass shape of an accepted track
+    std::size_t maxOutside = 0;
+
+    /// Binning of the lookup grid, none
+    /// to evaluate the filter directly
+    std::optional<HourglassGrid::Binning> grid;
+};
+
+// Hourglass classification of all hits of an event
+//
+// The hits of all tracks are classified in a single
+// batch over the hit columns and then counted per
+// track. Buffers are reused across events.
+class HourglassCounter {
+    public:
+        HourglassCounter(const HourglassCut& cut) : m_cut(cut) {
+            if (cut.grid.has_value()) {
+                m_grid.emplace(cut.filter, cut.grid.value());
+            }
+        }
+
+        // Count the hits inside and outside the
+        // hourglass shape of every track
+        //
+        // @par hits: hit columns of the tracks
+        // @par nTracks: number of tracks
+        void count(const HitColumns& hits, std::size_t nTracks) {
+            m_inside.resize(hits.x.size());
+            if (m_grid.has_value()) {
+                (*m_grid)(hits.x, hits.y, m_inside);
+            }
+            else {
+                m_cut.filter(hits.x, hits.y, m_inside);
+            }
+
+            m_nInside.assign(nTracks, 0);
+            m_nOutside.assign(nTracks, 0);
+            for (std::size_t i = 0; i < nTracks; i++) {
+                std::uint32_t inside = 0;
+                for (auto hit = hits.offsets[i]; hit < hits.offsets[i + 1]; hit++) {
+                    inside += m_inside[hit];
+                }
+                m_nInside[i] = inside;
+                m_nOutside[i] = hits.size(i) - inside;
+            }
+        }
+
+        // Hits of a track inside the hourglass shape
+        std::uint32_t nInside(std::size_t track) const {
+            return m_nInside[track];
+        }
+
+        // Hits of a track outside the hourglass shape
+        std::uint32_t nOutside(std::size_t track) const {
+            return m_nOutside[track];
+        }
+
+        // Whether a track passes the cut
+        bool passes(std::size_t track) const {
+            return m_nOutside[track] <= m_cut.maxOutside;
+        }
+
+    private:
+        HourglassCut m_cut;
+
+        std::optional<HourglassGrid> m_grid;
+
+        /// Classification of the hits of the event
+        std::vector<std::uint8_t> m_inside;
+
+        /// Per-track hit counts of the event
+        std::vector<std::uint32_t> m_nInside;
+        std::vector<std::uint32_t> m_nOutside;
 };
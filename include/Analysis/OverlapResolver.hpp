@@ -0,0 +1,200 @@
+#pragma once
+
+#include "include/Types/EventTracks.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+// Method of finding tracks that share hits
+enum class OverlapMethod {
+    /// Index of the hits by layer and position,
+    /// near-linear in the number of hits
+    Hashed,
+    /// Comparison of every pair of tracks
+    Pairwise
+};
+
+struct OverlapConfig {
+    OverlapMethod method = OverlapMethod::Hashed;
+
+    /// Minimal number of shared hits for two
+    /// tracks to overlap, 1 is any shared hit
+    std::size_t minSharedHits = 1;
+};
+
+// Flags the tracks of an event sharing hits
+//
+// Two tracks overlap if they have the same number
+// of hits and share at least minSharedHits hits on
+// the same layer, the position of the hit in the
+// track. Of every overlapping pair, the track with
+// the larger chi2/ndf is flagged as overlap. With a
+// threshold of 1 both methods give the flags of the
+// former pairwise removeOverlaps.
+class OverlapResolver {
+    public:
+        OverlapResolver(const OverlapConfig& cfg = OverlapConfig()) : m_cfg(cfg) {
+            if (cfg.minSharedHits == 0) {
+                throw std::invalid_argument("Overlaps need at least one shared hit");
+            }
+        }
+
+        const OverlapConfig& getConfig() const {
+            return m_cfg;
+        }
+
+        // Set isOverlap of the tracks of an event
+        //
+        // @par tracks: tracks of the event
+        void resolve(EventTracks& tracks) {
+            if (m_cfg.method == OverlapMethod::Pairwise) {
+                resolvePairwise(tracks);
+            }
+            else {
+                resolveHashed(tracks);
+            }
+        }
+
+    private:
+        OverlapConfig m_cfg;
+
+        // Hit of the index, identified by the hash of
+        // its layer, the track size and its position
+        struct HitEntry {
+            std::uint64_t hash;
+            std::uint32_t track;
+            std::uint32_t hit;
+        };
+
+        // Buffers reused across events
+        std::vector<HitEntry> m_entries;
+        std::vector<std::uint64_t> m_pairs;
+
+        // Flag the worse track of an overlapping pair
+        static void flag(EventTracks& tracks, std::size_t i, std::size_t j) {
+            if (tracks.chi2[i] / tracks.ndf[i] < tracks.chi2[j] / tracks.ndf[j]) {
+                tracks.isOverlap[j] = true;
+            } else {
+                tracks.isOverlap[i] = true;
+            }
+        }
+
+        static bool sameHit(const HitColumns& hits, std::size_t a, std::size_t b) {
+            return hits.x[a] == hits.x[b] &&
+                hits.y[a] == hits.y[b] &&
+                hits.z[a] == hits.z[b];
+        }
+
+        static std::uint64_t mix(std::uint64_t seed, std::uint64_t value) {
+            // 64-bit variant of boost::hash_combine
+            return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 12) + (seed >> 4));
+        }
+
+        // Adding zero maps -0 to +0, which compare equal
+        static std::uint64_t bits(double x) {
+            return std::bit_cast<std::uint64_t>(x + 0.0);
+        }
+
+        void resolvePairwise(EventTracks& tracks) {
+            const auto& hits = tracks.trackHits;
+            auto nShared = [&hits, this](std::size_t track1, std::size_t track2) {
+                const auto size = hits.size(track1);
+                if (size != hits.size(track2)) {
+                    return std::size_t(0);
+                }
+                const auto first1 = hits.offsets[track1];
+                const auto first2 = hits.offsets[track2];
+                std::size_t shared = 0;
+                for (std::size_t i = 0; i < size && shared < m_cfg.minSharedHits; i++) {
+                    shared += sameHit(hits, first1 + i, first2 + i);
+                }
+                return shared;
+            };
+
+            for (std::size_t i = 0; i < tracks.size(); i++) {
+                for (std::size_t j = i + 1; j < tracks.size(); j++) {
+                    if (nShared(i, j) >= m_cfg.minSharedHits) {
+                        flag(tracks, i, j);
+                    }
+                }
+            }
+        }
+
+        void resolveHashed(EventTracks& tracks) {
+            const auto& hits = tracks.trackHits;
+            const std::size_t n = tracks.size();
+
+            m_entries.clear();
+            for (std::size_t i = 0; i < n; i++) {
+                const auto size = hits.size(i);
+                const auto first = hits.offsets[i];
+                for (std::size_t layer = 0; layer < size; layer++) {
+                    const auto hit = first + layer;
+                    // NaN never compares equal
+                    if (std::isnan(hits.x[hit]) || std::isnan(hits.y[hit]) ||
+                        std::isnan(hits.z[hit])) {
+                            continue;
+                    }
+                    std::uint64_t hash = mix(size, layer);
+                    hash = mix(hash, bits(hits.x[hit]));
+                    hash = mix(hash, bits(hits.y[hit]));
+                    hash = mix(hash, bits(hits.z[hit]));
+                    m_entries.push_back({
+                        hash,
+                        static_cast<std::uint32_t>(i),
+                        static_cast<std::uint32_t>(hit)});
+                }
+            }
+
+            // Entries with the same hash become adjacent,
+            // ordered by track within each group
+            std::sort(m_entries.begin(), m_entries.end(),
+                [] (const HitEntry& a, const HitEntry& b) {
+                    return a.hash < b.hash || (a.hash == b.hash && a.track < b.track);
+                });
+
+            // Tracks of a group share the hit unless the hashes
+            // collide, so compare the hit keys to be exact
+            m_pairs.clear();
+            for (std::size_t begin = 0; begin < m_entries.size();) {
+                std::size_t end = begin + 1;
+                while (end < m_entries.size() && m_entries[end].hash == m_entries[begin].hash) {
+                    end++;
+                }
+                for (std::size_t a = begin; a < end; a++) {
+                    const auto& entryA = m_entries[a];
+                    const auto layerA = entryA.hit - hits.offsets[entryA.track];
+                    for (std::size_t b = a + 1; b < end; b++) {
+                        const auto& entryB = m_entries[b];
+                        if (entryA.track == entryB.track ||
+                            hits.size(entryA.track) != hits.size(entryB.track) ||
+                            layerA != entryB.hit - hits.offsets[entryB.track] ||
+                            !sameHit(hits, entryA.hit, entryB.hit)) {
+                                continue;
+                        }
+                        m_pairs.push_back(
+                            (std::uint64_t(entryA.track) << 32) | entryB.track);
+                    }
+                }
+                begin = end;
+            }
+
+            // Every shared hit adds the pair once
+            std::sort(m_pairs.begin(), m_pairs.end());
+            for (std::size_t begin = 0; begin < m_pairs.size();) {
+                std::size_t end = begin + 1;
+                while (end < m_pairs.size() && m_pairs[end] == m_pairs[begin]) {
+                    end++;
+                }
+                if (end - begin >= m_cfg.minSharedHits) {
+                    flag(tracks, m_pairs[begin] >> 32, m_pairs[begin] & 0xffffffff);
+                }
+                begin = end;
+            }
+        }
+};
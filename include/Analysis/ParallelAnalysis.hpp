@@ -0,0 +1,311 @@
+#pragma once
+
+#include "include/Io/TrackTreeReader.hpp"
+#include "include/Io/ReadAheadPipeline.hpp"
+#include "include/Analysis/AnalysisEngine.hpp"
+#include "include/Analysis/CutScan.hpp"
+#include "include/Analysis/Cuts.hpp"
+#include "include/detail/Profiler.hpp"
+#include "include/detail/ChunkScheduler.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "TROOT.h"
+
+// Process chunks of events concurrently
+//
+// Every worker owns a reader handle and analyzes each 
+// chunk it gets with an engine of its own. Finished 
+// chunks are merged strictly in chunk order, so the 
+// result does not depend on the number of threads or 
+// on the scheduling. Chunks are handed out in order and
+// at most a window of two chunks per worker ahead of
+// the merge, so only a few results wait for their turn,
+// and the merged engines are reset and reused.
+//
+// @par reader: reader of the dataset, a TrackTreeReader
+// or a ColumnarTrackReader
+// @par makeEngine: creates an empty engine, any type with
+// processEvent(eventId, tracks), merge(other) and reset()
+// @par chunks: event ids of every chunk, in merge order
+// @par nThreads: number of worker threads
+// @par onMerge: called with the merged engine and the
+// number of merged chunks after every merge, by the 
+// merging worker and outside the merge lock
+//
+// @return: engine with the merged results of all chunks
+template <typename Reader, typename MakeEngine, typename OnMerge>
+auto processChunksWith(
+    const Reader& reader, 
+    MakeEngine&& makeEngine,
+    const std::vector<std::vector<std::uint32_t>>& chunks,
+    std::size_t nThreads,
+    OnMerge&& onMerge) {
+        using Engine = decltype(makeEngine());
+
+        // Every worker opens its own chain
+        ROOT::EnableThreadSafety();
+
+        const std::size_t nChunks = chunks.size();
+        nThreads = std::clamp<std::size_t>(nThreads, 1, std::max<std::size_t>(nChunks, 1));
+
+        ChunkScheduler scheduler(nChunks, 2 * nThreads);
+
+        // Chunks finished out of order wait here until 
+        // their turn to be merged, merged engines wait 
+        // in the pool to be reused
+        Engine merged = makeEngine();
+        std::map<std::size_t, Engine> pending;
+        std::vector<Engine> pool;
+        std::size_t nextMerge = 0;
+        bool merging = false;
+        std::mutex mergeMutex;
+
+        std::vector<std::exception_ptr> errors(nThreads);
+        auto work = [&] (std::size_t worker) {
+            try {
+                Reader workerReader(reader);
+                while (auto chunk = scheduler.next()) {
+                    std::optional<Engine> engine;
+                    {
+                        std::lock_guard<std::mutex> lock(mergeMutex);
+                        if (!pool.empty()) {
+                            engine.emplace(std::move(pool.back()));
+                            pool.pop_back();
+                        }
+                    }
+                    if (!engine.has_value()) {
+                        engine.emplace(makeEngine());
+                    }
+                    workerReader.forEachEvent(chunks.at(chunk.value()),
+                        [&engine] (std::uint32_t id, EventTracks& tracks) {
+                            engine->processEvent(id, tracks);
+                        }
+                    );
+
+                    // A single worker at a time merges the
+                    // chunks that are next in order, the 
+                    // others go on with their chunks
+                    std::unique_lock<std::mutex> lock(mergeMutex);
+                    pending.emplace(chunk.value(), std::move(engine.value()));
+                    if (merging) {
+                        continue;
+                    }
+                    merging = true;
+                    for (auto it = pending.find(nextMerge); it != pending.end(); 
+                        it = pending.find(nextMerge)) {
+                            Engine next = std::move(it->second);
+                            pending.erase(it);
+                            const std::size_t nMerged = ++nextMerge;
+                            lock.unlock();
+
+                            {
+                                ScopedTimer timer(Stage::Merge);
+                                merged.merge(next);
+                            }
+                            next.reset();
+                            scheduler.merged(nMerged);
+                            onMerge(std::as_const(merged), nMerged);
+
+                            lock.lock();
+                            pool.push_back(std::move(next));
+                    }
+                    merging = false;
+                }
+            }
+            catch (...) {
+                errors.at(worker) = std::current_exception();
+                scheduler.stop();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (std::size_t i = 0; i < nThreads; i++) {
+            workers.emplace_back(work, i);
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        for (const auto& error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+        return merged;
+}
+
+// Process chunks of events concurrently
+// with the analysis engine
+//
+// @par reader: reader of the dataset
+// @par cuts: cuts of the analysis
+// @par chunks: event ids of every chunk, in merge order
+// @par nThreads: number of worker threads
+// @par onMerge: called with the merged engine and the
+// number of merged chunks after every merge, outside 
+// the merge lock, e.g. to write checkpoints
+//
+// @return: engine with the merged results of all chunks
+template <typename Reader>
+AnalysisEngine processChunksParallel(
+    const Reader& reader, 
+    const Cuts& cuts,
+    const std::vector<std::vector<std::uint32_t>>& chunks,
+    std::size_t nThreads,
+    const std::function<void(const AnalysisEngine&, std::size_t)>& onMerge = {}) {
+        return processChunksWith(
+            reader,
+            [&cuts] () { return AnalysisEngine(cuts); },
+            chunks,
+            nThreads,
+            [&onMerge] (const AnalysisEngine& merged, std::size_t nMerged) {
+                if (onMerge) {
+                    onMerge(merged, nMerged);
+                }
+            });
+}
+
+// Process the files of a dataset concurrently
+//
+// Events that continue into later files belong to the
+// file of their first entry and are read completely, 
+// so the merged result is the same as for a single 
+// merged file.
+//
+// @par reader: reader of the dataset
+// @par cuts: cuts of the analysis
+// @par nThreads: number of worker threads
+//
+// @return: engine with the merged results of all files
+template <typename Reader>
+AnalysisEngine processFilesParallel(
+    const Reader& reader, 
+    const Cuts& cuts,
+    std::size_t nThreads = std::thread::hardware_concurrency()) {
+        std::vector<std::vector<std::uint32_t>> chunks;
+        for (std::size_t i = 0; i < reader.getFilePaths().size(); i++) {
+            chunks.push_back(reader.getEventsInFile(i));
+        }
+        return processChunksParallel(reader, cuts, chunks, nThreads);
+}
+
+// Split events in file order into chunks of fixed size
+inline std::vector<std::vector<std::uint32_t>> splitEvents(
+    const std::vector<std::uint32_t>& events,
+    std::size_t chunkSize) {
+        chunkSize = std::max<std::size_t>(chunkSize, 1);
+
+        std::vector<std::vector<std::uint32_t>> chunks;
+        for (std::size_t first = 0; first < events.size(); first += chunkSize) {
+            auto last = std::min(first + chunkSize, events.size());
+            chunks.emplace_back(events.begin() + first, events.begin() + last);
+        }
+        return chunks;
+}
+
+// Process the events of a dataset concurrently
+//
+// Events are split in file order into chunks of fixed
+// size, independent of the number of threads, so the
+// outputs are bit-identical for any thread count.
+//
+// @par reader: reader of the dataset
+// @par cuts: cuts of the analysis
+// @par events: events to process, in file order
+// @par nThreads: number of worker threads
+// @par chunkSize: number of events per chunk
+//
+// @return: engine with the merged results of the events
+template <typename Reader>
+AnalysisEngine processEventsParallel(
+    const Reader& reader, 
+    const Cuts& cuts,
+    const std::vector<std::uint32_t>& events,
+    std::size_t nThreads = std::thread::hardware_concurrency(),
+    std::size_t chunkSize = 1000) {
+        return processChunksParallel(reader, cuts, splitEvents(events, chunkSize), nThreads);
+}
+
+// Process all events of a dataset concurrently
+template <typename Reader>
+AnalysisEngine processEventsParallel(
+    const Reader& reader, 
+    const Cuts& cuts,
+    std::size_t nThreads = std::thread::hardware_concurrency(),
+    std::size_t chunkSize = 1000) {
+        return processEventsParallel(
+            reader, cuts, reader.getEventsInFileOrder(), nThreads, chunkSize);
+}
+
+// Process the events of a dataset on the calling
+// thread while producers decode the upcoming events
+//
+// @par reader: reader of the dataset
+// @par cuts: cuts of the analysis
+// @par events: events to process, in file order
+// @par cfg: queue depth, batch size and number
+// of producers of the read-ahead pipeline
+//
+// @return: engine with the results of the events
+template <typename Reader>
+AnalysisEngine processEventsPipelined(
+    const Reader& reader, 
+    const Cuts& cuts,
+    const std::vector<std::uint32_t>& events,
+    const ReadAheadConfig& cfg = {}) {
+        ROOT::EnableThreadSafety();
+
+        AnalysisEngine engine(cuts);
+        ReadAheadPipeline<Reader> pipeline(reader, cfg);
+        pipeline.forEachEvent(events,
+            [&engine] (std::uint32_t id, EventTracks& tracks) {
+                engine.processEvent(id, tracks);
+            }
+        );
+        return engine;
+}
+
+// Process all events of a dataset on the calling
+// thread while producers decode the upcoming events
+template <typename Reader>
+AnalysisEngine processEventsPipelined(
+    const Reader& reader, 
+    const Cuts& cuts,
+    const ReadAheadConfig& cfg = {}) {
+        return processEventsPipelined(reader, cuts, reader.getEventsInFileOrder(), cfg);
+}
+
+// Scan the thresholds of one or two cuts over
+// the events of a dataset in a single pass
+//
+// @par reader: reader of the dataset
+// @par cuts: cuts of the analysis
+// @par axes: scanned cuts and their thresholds
+// @par events: events to process, in file order
+// @par nThreads: number of worker threads
+// @par chunkSize: number of events per chunk
+//
+// @return: scan engine with the merged results
+template <typename Reader>
+ScanEngine processScanParallel(
+    const Reader& reader, 
+    const Cuts& cuts,
+    const std::vector<ScanAxis>& axes,
+    const std::vector<std::uint32_t>& events,
+    std::size_t nThreads = std::thread::hardware_concurrency(),
+    std::size_t chunkSize = 1000) {
+        return processChunksWith(
+            reader,
+            [&cuts, &axes] () { return ScanEngine(cuts, axes); },
+            splitEvents(events, chunkSize),
+            nThreads,
+            [] (const ScanEngine&, std::size_t) {});
+}
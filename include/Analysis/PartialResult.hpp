@@ -0,0 +1,159 @@
+#pragma once
+
+#include "include/Analysis/EventStats.hpp"
+#include "include/Analysis/TrackHistogramSet.hpp"
+#include "include/detail/HelperFunctions.hpp"
+#include "include/detail/Profiler.hpp"
+
+#include <map>
+#include <stdexcept>
+#include <string>
+
+#include "TFile.h"
+#include "TH1.h"
+#include "TParameter.h"
+#include "TVectorD.h"
+
+// Raw results of a subset of the events, mergeable
+// with the results of disjoint subsets
+//
+// A partial file holds the histograms of every matching
+// degree as they are filled, the per-cut sums and
+// accept counts of the cut flows, the degrees and the
+// track and event counts. The final cut flows are only
+// built by store, once all partial results are merged.
+struct PartialResult {
+    struct DegreeResult {
+        /// Histograms of the tracks passing the cuts
+        TrackHistogramSet histSet;
+
+        /// Cut flow of the events with tracks of the
+        /// degree, the other events are only counted
+        /// in the total number of events
+        CutFlowSummary cutFlow;
+    };
+
+    std::map<double, DegreeResult> degrees;
+
+    /// Number of tracks passing all cuts
+    double nTracks = 0;
+
+    /// Number of processed events
+    double nEvents = 0;
+
+    // Merge the results of a disjoint set of events
+    void merge(const PartialResult& other) {
+        for (const auto& [matchingDegree, otherDegree] : other.degrees) {
+            auto& degree = getDegree(matchingDegree);
+            degree.histSet.add(otherDegree.histSet);
+            degree.cutFlow.add(otherDegree.cutFlow);
+        }
+        nTracks += other.nTracks;
+        nEvents += other.nEvents;
+    }
+
+    // Write the raw results to a partial file
+    void write(TFile* file) const {
+        ScopedTimer timer(Stage::Write);
+        file->cd();
+
+        TVectorD matchingDegrees(degrees.size());
+        int i = 0;
+        for (const auto& [matchingDegree, degree] : degrees) {
+            matchingDegrees[i++] = matchingDegree;
+
+            storeTrackHistograms(file, degree.histSet);
+
+            // Sums followed by the accept counts, in cut order
+            const std::size_t nCuts = degree.cutFlow.sum.size();
+            TVectorD counts(2 * nCuts);
+            for (std::size_t k = 0; k < nCuts; k++) {
+                counts[k] = degree.cutFlow.sum.at(k);
+                counts[nCuts + k] = degree.cutFlow.accept.at(k);
+            }
+            counts.Write(countsName(matchingDegree).c_str());
+        }
+        matchingDegrees.Write("matchingDegrees");
+
+        TParameter<double>("nTracks", nTracks).Write();
+        TParameter<double>("nEvents", nEvents).Write();
+    }
+
+    // Read the raw results from a partial file
+    static PartialResult read(TFile* file) {
+        PartialResult result;
+        result.nTracks = getObject<TParameter<double>>(file, "nTracks")->GetVal();
+        result.nEvents = getObject<TParameter<double>>(file, "nEvents")->GetVal();
+
+        const auto& matchingDegrees = *getObject<TVectorD>(file, "matchingDegrees");
+        for (int i = 0; i < matchingDegrees.GetNrows(); i++) {
+            auto& degree = result.getDegree(matchingDegrees[i]);
+            for (auto& histogram : degree.histSet.histograms()) {
+                histogram.add(*getObject<TH1D>(file, histogram.name()));
+            }
+
+            const auto& counts = *getObject<TVectorD>(
+                file, countsName(matchingDegrees[i]));
+            const std::size_t nCuts = degree.cutFlow.sum.size();
+            if (counts.GetNrows() != static_cast<int>(2 * nCuts)) {
+                throw std::invalid_argument("Partial result built from other cuts");
+            }
+            for (std::size_t k = 0; k < nCuts; k++) {
+                degree.cutFlow.sum.at(k) = counts[k];
+                degree.cutFlow.accept.at(k) = counts[nCuts + k];
+            }
+        }
+        return result;
+    }
+
+    // Write the final histograms and cut flows
+    // of every matching degree
+    //
+    // @par outFile: output file
+    // @par method: method of the cut flow intervals
+    void store(
+        TFile* outFile, 
+        IntervalMethod method = IntervalMethod::ProfileLikelihood) {
+        ScopedTimer timer(Stage::Write);
+        for (auto& [matchingDegree, degree] : degrees) {
+            storeTrackHistograms(outFile, degree.histSet);
+
+            // Events without tracks of this degree
+            // still enter the cut flow normalization
+            CutFlowSummary summary = degree.cutFlow;
+            summary.nEvents = nEvents;
+
+            auto [cutFlow, cutFlowErrs] =
+                getCutFlow(summary, std::to_string(matchingDegree), -1, method);
+            cutFlow->Write();
+            cutFlowErrs->Write();
+        }
+    }
+
+    // Get the results of the matching degree,
+    // creating them on first encounter
+    DegreeResult& getDegree(double matchingDegree) {
+        auto it = degrees.find(matchingDegree);
+        if (it != degrees.end()) {
+            return it->second;
+        }
+        return degrees.emplace(
+            matchingDegree,
+            DegreeResult{
+                TrackHistogramSet(std::to_string(matchingDegree)),
+                {}}).first->second;
+    }
+
+    static std::string countsName(double matchingDegree) {
+        return "cutFlowCounts_" + std::to_string(matchingDegree);
+    }
+
+    template <typename T>
+    static T* getObject(TFile* file, const std::string& name) {
+        auto obj = file->Get<T>(name.c_str());
+        if (!obj) {
+            throw std::invalid_argument("Missing " + name + " in partial result");
+        }
+        return obj;
+    }
+};
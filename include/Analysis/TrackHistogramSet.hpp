@@ -1,21 +1,26 @@
 #pragma once
 
 #include "include/Analysis/AnalysisUnit.hpp"
+#include "include/Analysis/Histogram.hpp"
+#include "include/Analysis/UnitRegistry.hpp"
 #include "include/Types/Track.hpp"
+#include "include/Types/EventTracks.hpp"
 
+#include <cstdint>
+#include <span>
+#include <stdexcept>
 #include <string>
-#include <map>
-
-#include "TH1.h"
+#include <vector>
 
 class TrackHistogramSet {
     public:
         TrackHistogramSet(std::string suffix) : m_suffix(suffix) {
-            // Initialize histograms
-            for (auto unit : units) {
-                m_histograms.insert({new TH1D(
-                    (unit.name + "_" + m_suffix).c_str(), "", 
-                    unit.nBins, unit.low, unit.high), unit.getter});
+            // Initialize histograms in unit order
+            for (const auto& unit : units) {
+                m_histograms.emplace_back(
+                    unit.name + "_" + m_suffix, 
+                    unit.nBins, unit.low, unit.high);
+                m_getters.push_back(unit.getter);
             }
 
             // Suffix
@@ -26,18 +31,86 @@ class TrackHistogramSet {
             return m_suffix;
         }
 
-        const std::map<TH1D*, Track::Getter>& histograms() const {
+        const std::vector<Histogram>& histograms() const {
+            return m_histograms;
+        }
+
+        std::vector<Histogram>& histograms() {
             return m_histograms;
         }
 
-        void fill(const Track& track) {
-            for (auto& [hist, getter] : m_histograms) {
-                hist->Fill(getter(track));
+        void fill(const TrackView& track) {
+            for (std::size_t k = 0; k < m_histograms.size(); k++) {
+                m_histograms[k].fill(m_getters[k](track));
+            }
+        }
+
+        // Fill through the statically dispatched getters,
+        // valid while the units match the registry
+        void fillStatic(const TrackView& track) {
+            UnitRegistry::fill(track, m_histograms);
+        }
+
+        // Fill the selected tracks of an event one unit
+        // at a time, in the order of the selection
+        //
+        // @par tracks: tracks of the event
+        // @par selected: indices of the tracks to fill
+        // @par isStatic: units match the registry and 
+        // the getters are dispatched statically
+        void fill(
+            const EventTracks& tracks, 
+            std::span<const std::uint32_t> selected,
+            bool isStatic) {
+                if (selected.empty()) {
+                    return;
+                }
+                m_values.resize(selected.size());
+                if (isStatic) {
+                    UnitRegistry::forEach(
+                        [&] (const auto& unit, auto I) {
+                            using Unit = std::remove_cvref_t<decltype(unit)>;
+                            for (std::size_t i = 0; i < selected.size(); i++) {
+                                m_values[i] = Unit::get(tracks.view(selected[i]));
+                            }
+                            m_histograms[I].fill(m_values);
+                        }
+                    );
+                    return;
+                }
+                for (std::size_t k = 0; k < m_histograms.size(); k++) {
+                    for (std::size_t i = 0; i < selected.size(); i++) {
+                        m_values[i] = m_getters[k](tracks.view(selected[i]));
+                    }
+                    m_histograms[k].fill(m_values);
+                }
+        }
+
+        // Add the histograms of a set 
+        // built from the same units
+        void add(const TrackHistogramSet& other) {
+            if (other.m_histograms.size() != m_histograms.size()) {
+                throw std::invalid_argument("Histogram sets of different units");
+            }
+            for (std::size_t k = 0; k < m_histograms.size(); k++) {
+                m_histograms[k].add(other.m_histograms[k]);
+            }
+        }
+
+        // Clear the histograms, keeping their bins
+        void reset() {
+            for (auto& histogram : m_histograms) {
+                histogram.reset();
             }
         }
 
     private:
         std::string m_suffix;
 
-        std::map<TH1D*, Track::Getter> m_histograms;
+        // Histograms and getters in the order of the units
+        std::vector<Histogram> m_histograms;
+        std::vector<Track::Getter> m_getters;
+
+        // Getter values of the current unit
+        std::vector<double> m_values;
 };
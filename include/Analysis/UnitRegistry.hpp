@@ -0,0 +1,130 @@
+#pragma once
+
+#include "include/Analysis/AnalysisUnit.hpp"
+#include "include/Analysis/Cuts.hpp"
+#include "include/Analysis/EventStats.hpp"
+#include "include/Analysis/Histogram.hpp"
+#include "include/Types/Track.hpp"
+
+#include <cstddef>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Statically dispatched loops over the unit registry
+//
+// The loops are unrolled over staticUnits at compile
+// time, so every getter is a direct, inlinable call.
+// They apply as long as the runtime units and cuts
+// still describe the registry, which matches checks.
+namespace UnitRegistry {
+    inline constexpr std::size_t nUnits =
+        std::tuple_size_v<std::remove_cv_t<decltype(staticUnits)>>;
+
+    // Call f(unit, index) for every unit of the registry
+    template <typename F>
+    constexpr void forEach(F&& f) {
+        [&] <std::size_t... I> (std::index_sequence<I...>) {
+            (f(std::get<I>(staticUnits), std::integral_constant<std::size_t, I>()), ...);
+        }(std::make_index_sequence<nUnits>());
+    }
+
+    // Index of the unit among the units with a cut
+    template <std::size_t I>
+    constexpr std::size_t cutIndex() {
+        std::size_t k = 0;
+        forEach(
+            [&k] (const auto& unit, auto J) {
+                if (J < I && unit.range.has_value()) {
+                    k++;
+                }
+            }
+        );
+        return k;
+    }
+
+    // Whether the runtime units are the registry units,
+    // including their getters
+    inline bool matches(const std::vector<AnalysisUnit>& analysisUnits) {
+        if (analysisUnits.size() != nUnits) {
+            return false;
+        }
+        bool same = true;
+        forEach(
+            [&] (const auto& unit, auto I) {
+                using Unit = std::remove_cvref_t<decltype(unit)>;
+                const auto& other = analysisUnits.at(I);
+                same = same &&
+                    Unit::holds(other.getter) &&
+                    other.name == unit.name &&
+                    other.range.has_value() == unit.range.has_value() &&
+                    other.nBins == unit.nBins &&
+                    other.low == unit.low &&
+                    other.high == unit.high;
+            }
+        );
+        return same;
+    }
+
+    // Whether the cuts are the cuts of the registry,
+    // including their getters, the ranges themselves
+    // may differ
+    inline bool matches(const Cuts& cuts) {
+        bool same = true;
+        std::size_t k = 0;
+        forEach(
+            [&] (const auto& unit, auto) {
+                using Unit = std::remove_cvref_t<decltype(unit)>;
+                if (!unit.range.has_value()) {
+                    return;
+                }
+                same = same && k < cuts.cuts.size() &&
+                    cuts.cuts.at(k).name == unit.name &&
+                    Unit::holds(cuts.cuts.at(k).getter);
+                k++;
+            }
+        );
+        return same && k == cuts.cuts.size();
+    }
+
+    // Apply the cuts in registry order, stopping
+    // at the first failed cut, same as processTrack
+    //
+    // @par track: track to check
+    // @par evStat: statistics of the event of the track
+    // @par cuts: cuts matching the registry
+    //
+    // @return: whether the track passes all cuts
+    inline bool processTrack(
+        const TrackView& track,
+        EventStats& evStat,
+        const Cuts& cuts) {
+            auto check = [&] (const auto& unit, auto I) {
+                using Unit = std::remove_cvref_t<decltype(unit)>;
+                if constexpr (std::get<I>(staticUnits).range.has_value()) {
+                    constexpr auto k = cutIndex<I>();
+                    const auto& range = cuts.cuts[k].range;
+                    const double value = Unit::get(track);
+                    if (range.first > value || range.second < value) {
+                        return false;
+                    }
+                    evStat.cutFlow.flow[k]++;
+                }
+                return true;
+            };
+            return [&] <std::size_t... I> (std::index_sequence<I...>) {
+                return (check(std::get<I>(staticUnits),
+                    std::integral_constant<std::size_t, I>()) && ...);
+            }(std::make_index_sequence<nUnits>());
+    }
+
+    // Fill the histograms of the units in registry order
+    inline void fill(const TrackView& track, std::vector<Histogram>& histograms) {
+        forEach(
+            [&] (const auto& unit, auto I) {
+                using Unit = std::remove_cvref_t<decltype(unit)>;
+                histograms[I].fill(Unit::get(track));
+            }
+        );
+    }
+} // namespace UnitRegistry
@@ -0,0 +1,656 @@
+#pragma once
+
+#include "include/Types/Track.hpp"
+#include "include/Types/EventTracks.hpp"
+#include "include/Types/TreeColumns.hpp"
+#include "include/Io/EventIndex.hpp"
+#include "include/Io/TrackTreeReader.hpp"
+#include "include/detail/Profiler.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Layout of the columnar track cache
+//
+// The file starts with a fixed header and a column
+// directory, followed by the uncompressed columns,
+// each holding the values of all tracks in file order
+// and aligned to a cache line. Events are stored
+// contiguously, so every event is a single range of
+// track indices.
+struct ColumnarLayout {
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t nColumns;
+        std::uint64_t nTracks;
+        std::uint64_t nEvents;
+        std::uint64_t nInputEvents;
+    };
+
+    struct ColumnEntry {
+        char name[48];
+        std::uint64_t offset;
+        std::uint64_t size;
+    };
+
+    // Temporary file a column is streamed into
+    struct ColumnSink {
+        std::string name;
+        std::string path;
+        std::ofstream out;
+        std::uint64_t size = 0;
+
+        template <typename T>
+        void write(const T* data, std::size_t n) {
+            out.write(reinterpret_cast<const char*>(data), n * sizeof(T));
+            size += n * sizeof(T);
+        }
+    };
+
+    static constexpr char magic[8] = {'O', 'T', 'A', 'C', 'O', 'L', 'S', '\0'};
+    static constexpr std::uint32_t version = 2;
+    static constexpr std::size_t alignment = 64;
+
+    /// Names of the index columns
+    static constexpr const char* eventRanges = "eventRanges";
+    static constexpr const char* matchingDegrees = "matchingDegrees";
+
+    /// Name of the cache in its event index
+    static constexpr const char* treeName = "columnar";
+};
+
+// Convert a fitted-tracks dataset into the columnar cache
+//
+// The columns the reader does not read are not stored
+// and read back with default values. The post-processing
+// flags of a skim are stored with the columns.
+//
+// @par reader: reader of the dataset
+// @par path: path of the cache file
+inline void writeColumnarCache(TrackTreeReader& reader, const std::string& path) {
+    // Every column is streamed into its own
+    // temporary file and concatenated at the end
+    using ColumnSink = ColumnarLayout::ColumnSink;
+    std::vector<std::unique_ptr<ColumnSink>> sinks;
+    auto addSink = [&] (const std::string& name) {
+        auto sink = std::make_unique<ColumnSink>();
+        sink->name = name;
+        sink->path = path + ".tmp." + name;
+        sink->out.open(sink->path, std::ios::binary | std::ios::trunc);
+        if (!sink->out) {
+            throw std::runtime_error("Cannot write " + sink->path);
+        }
+        sinks.push_back(std::move(sink));
+        return sinks.back().get();
+    };
+
+    const auto& columns = reader.getConfig().columns;
+    auto isRead = [&columns] (const char* name) {
+        return columns.empty() || std::ranges::find(columns, name) != columns.end();
+    };
+
+    std::vector<std::pair<ColumnSink*, std::vector<double> EventTracks::*>> doubleSinks;
+    for (const auto& [name, member] : TreeColumns::doubleKeys) {
+        if (isRead(name)) {
+            doubleSinks.push_back({addSink(name), member});
+        }
+    }
+    std::vector<std::pair<ColumnSink*, std::vector<int> EventTracks::*>> intSinks;
+    for (const auto& [name, member] : TreeColumns::intKeys) {
+        if (isRead(name)) {
+            intSinks.push_back({addSink(name), member});
+        }
+    }
+    std::vector<std::pair<ColumnSink*, std::vector<Vector3> EventTracks::*>> vector3Sinks;
+    for (const auto& [name, member] : TreeColumns::vector3Keys) {
+        if (isRead(name)) {
+            vector3Sinks.push_back({addSink(name), member});
+        }
+    }
+    std::vector<std::pair<ColumnSink*, std::vector<LorentzVector> EventTracks::*>> lorentzSinks;
+    for (const auto& [name, member] : TreeColumns::lorentzKeys) {
+        if (isRead(name)) {
+            lorentzSinks.push_back({addSink(name), member});
+        }
+    }
+    ColumnSink* overlapSink = nullptr;
+    ColumnSink* multipleSink = nullptr;
+    if (reader.hasStoredFlags()) {
+        overlapSink = addSink(SkimWriter::overlapBranch);
+        multipleSink = addSink(SkimWriter::multipleBranch);
+    }
+    struct HitSinks {
+        ColumnSink* offsets;
+        ColumnSink* x;
+        ColumnSink* y;
+        ColumnSink* z;
+        HitColumns EventTracks::* member;
+        std::uint64_t nHits = 0;
+    };
+    std::vector<HitSinks> hitSinks;
+    for (const auto& [name, trackMember, member] : EventTracks::hitMembers) {
+        if (isRead(name)) {
+            std::string base = name;
+            hitSinks.push_back({
+                addSink(base + ".offsets"),
+                addSink(base + ".x"), addSink(base + ".y"), addSink(base + ".z"),
+                member});
+            std::uint64_t first = 0;
+            hitSinks.back().offsets->write(&first, 1);
+        }
+    }
+
+    std::vector<EventRange> ranges;
+    std::uint64_t nTracks = 0;
+    reader.forEachEvent(
+        [&] (std::uint32_t eventId, EventTracks& tracks) {
+            ranges.push_back({eventId, nTracks, nTracks + tracks.size()});
+            nTracks += tracks.size();
+
+            for (auto& [sink, member] : doubleSinks) {
+                sink->write((tracks.*member).data(), tracks.size());
+            }
+            for (auto& [sink, member] : intSinks) {
+                sink->write((tracks.*member).data(), tracks.size());
+            }
+            for (auto& [sink, member] : vector3Sinks) {
+                sink->write((tracks.*member).data(), tracks.size());
+            }
+            for (auto& [sink, member] : lorentzSinks) {
+                sink->write((tracks.*member).data(), tracks.size());
+            }
+            if (overlapSink) {
+                overlapSink->write(tracks.isOverlap.data(), tracks.size());
+                multipleSink->write(tracks.isMultiple.data(), tracks.size());
+            }
+            for (auto& hits : hitSinks) {
+                const auto& column = tracks.*hits.member;
+                for (std::size_t i = 1; i < column.offsets.size(); i++) {
+                    std::uint64_t offset = hits.nHits + column.offsets.at(i);
+                    hits.offsets->write(&offset, 1);
+                }
+                hits.x->write(column.x.data(), column.x.size());
+                hits.y->write(column.y.data(), column.y.size());
+                hits.z->write(column.z.data(), column.z.size());
+                hits.nHits += column.x.size();
+            }
+        }
+    );
+    addSink(ColumnarLayout::eventRanges)->write(ranges.data(), ranges.size());
+    const auto& matchingDegrees = reader.getMatchingDegrees();
+    addSink(ColumnarLayout::matchingDegrees)->write(
+        matchingDegrees.data(), matchingDegrees.size());
+
+    for (auto& sink : sinks) {
+        sink->out.close();
+        if (!sink->out) {
+            throw std::runtime_error("Cannot write " + sink->path);
+        }
+    }
+
+    // Lay out the columns after the directory
+    auto align = [] (std::uint64_t offset) {
+        return (offset + ColumnarLayout::alignment - 1) /
+            ColumnarLayout::alignment * ColumnarLayout::alignment;
+    };
+    ColumnarLayout::Header header{};
+    std::copy(ColumnarLayout::magic, ColumnarLayout::magic + 8, header.magic);
+    header.version = ColumnarLayout::version;
+    header.nColumns = sinks.size();
+    header.nTracks = nTracks;
+    header.nEvents = ranges.size();
+    header.nInputEvents = reader.getInputEvents();
+
+    std::vector<ColumnarLayout::ColumnEntry> directory(sinks.size());
+    std::uint64_t offset = align(
+        sizeof(header) + directory.size() * sizeof(ColumnarLayout::ColumnEntry));
+    for (std::size_t i = 0; i < sinks.size(); i++) {
+        std::strncpy(directory.at(i).name, sinks.at(i)->name.c_str(),
+            sizeof(directory.at(i).name) - 1);
+        directory.at(i).offset = offset;
+        directory.at(i).size = sinks.at(i)->size;
+        offset = align(offset + sinks.at(i)->size);
+    }
+
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(directory.data()),
+            directory.size() * sizeof(ColumnarLayout::ColumnEntry));
+        for (std::size_t i = 0; i < sinks.size(); i++) {
+            // Pad up to the aligned column start
+            std::vector<char> padding(directory.at(i).offset - out.tellp(), 0);
+            out.write(padding.data(), padding.size());
+
+            std::ifstream in(sinks.at(i)->path, std::ios::binary);
+            if (sinks.at(i)->size > 0) {
+                out << in.rdbuf();
+            }
+            in.close();
+            std::filesystem::remove(sinks.at(i)->path);
+        }
+        if (!out) {
+            throw std::runtime_error("Cannot write " + tmpPath);
+        }
+    }
+    std::filesystem::rename(tmpPath, path);
+}
+
+// Reader of the columnar track cache
+//
+// The cache is memory-mapped and events are staged
+// with plain copies out of the mapping, exposing the
+// same event and track API as TrackTreeReader
+class ColumnarTrackReader {
+    public:
+        struct Config {
+            /// Path of the cache file
+            std::string filePath;
+            /// Columns to read, all stored columns
+            /// are read if empty
+            std::vector<std::string> columns = {};
+        };
+
+        ColumnarTrackReader(const Config& cfg) : m_cfg(cfg) {
+            m_mapping = std::make_shared<Mapping>(m_cfg.filePath);
+            prepareColumns();
+        }
+
+        // Open an independent handle sharing the mapping
+        ColumnarTrackReader(const ColumnarTrackReader& other) :
+            m_cfg(other.m_cfg),
+            m_mapping(other.m_mapping),
+            m_columns(other.m_columns),
+            m_doubleColumns(other.m_doubleColumns),
+            m_intColumns(other.m_intColumns),
+            m_vector3Columns(other.m_vector3Columns),
+            m_lorentzColumns(other.m_lorentzColumns),
+            m_hitColumns(other.m_hitColumns),
+            m_isOverlap(other.m_isOverlap),
+            m_isMultiple(other.m_isMultiple),
+            m_hasFlags(other.m_hasFlags),
+            m_ranges(other.m_ranges),
+            m_index(other.m_index),
+            m_eventIndex(other.m_eventIndex),
+            m_matchingDegrees(other.m_matchingDegrees),
+            m_nInputEvents(other.m_nInputEvents) {}
+
+        ColumnarTrackReader& operator=(const ColumnarTrackReader&) = delete;
+
+        // Get the sorted list of events
+        std::vector<std::uint32_t> getEvents() const {
+            auto events = getEventsInFileOrder();
+            std::sort(events.begin(), events.end());
+            return events;
+        }
+
+        // Get the list of events in file order
+        std::vector<std::uint32_t> getEventsInFileOrder() const {
+            std::vector<std::uint32_t> events;
+            events.reserve(m_ranges.size());
+            for (const auto& range : m_ranges) {
+                events.push_back(range.eventId);
+            }
+            return events;
+        }
+
+        // Get the paths of the files of the dataset,
+        // the cache is a single file
+        const std::vector<std::string>& getFilePaths() const {
+            return m_index->filePaths;
+        }
+
+        // Get the events of a file of the dataset in file order
+        std::vector<std::uint32_t> getEventsInFile(std::size_t fileIdx) const {
+            if (fileIdx >= getFilePaths().size()) {
+                throw std::out_of_range("No file " + std::to_string(fileIdx) + " in the cache");
+            }
+            return getEventsInFileOrder();
+        }
+
+        // Get the track ranges of the events in file order
+        std::span<const EventRange> getEventRanges() const {
+            return m_ranges;
+        }
+
+        // Get the number of events of the dataset, for a
+        // cache of a skim the events of the skim input
+        std::size_t getInputEvents() const {
+            return m_nInputEvents;
+        }
+
+        // Get the event index of the cache, 
+        // keyed by the state of the cache file
+        const EventIndex& getIndex() const {
+            return m_index->index;
+        }
+
+        // Get the distinct matching degrees of the tracks
+        std::span<const double> getMatchingDegrees() const {
+            return m_matchingDegrees;
+        }
+
+        // Extract all tracks
+        std::vector<Track> getTracks() {
+            std::vector<Track> tracks;
+            forEachEvent(
+                [&tracks] (std::uint32_t, EventTracks& eventTracks) {
+                    for (std::size_t i = 0; i < eventTracks.size(); i++) {
+                        tracks.push_back(eventTracks.view(i).materialize());
+                    }
+                }
+            );
+            return tracks;
+        }
+
+        // Extract tracks for a specific event
+        std::vector<Track> getTracksForEvent(std::uint32_t eventN) {
+            readEvent(eventN, m_eventBuffer);
+
+            std::vector<Track> tracks;
+            tracks.reserve(m_eventBuffer.size());
+            for (std::size_t i = 0; i < m_eventBuffer.size(); i++) {
+                tracks.push_back(m_eventBuffer.view(i).materialize());
+            }
+            return tracks;
+        }
+
+        // Visit the tracks of every event in file order
+        //
+        // @par visitor: callable taking the event id
+        // and the EventTracks& of the event
+        template <typename Visitor>
+        void forEachEvent(Visitor&& visitor) {
+            forEachEvent(getEventsInFileOrder(), visitor);
+        }
+
+        // Visit the tracks of the given events in order
+        //
+        // @par events: ids of the events to visit
+        // @par visitor: callable taking the event id
+        // and the EventTracks& of the event
+        template <typename Visitor>
+        void forEachEvent(
+            const std::vector<std::uint32_t>& events, Visitor&& visitor) {
+                for (auto eventId : events) {
+                    readEvent(eventId, m_eventBuffer);
+                    visitor(eventId, m_eventBuffer);
+                }
+        }
+
+        // Visit every track in file order
+        //
+        // @par visitor: callable taking a const TrackView&
+        template <typename Visitor>
+        void forEachTrack(Visitor&& visitor) {
+            forEachEvent(
+                [&visitor] (std::uint32_t, const EventTracks& tracks) {
+                    for (std::size_t i = 0; i < tracks.size(); i++) {
+                        visitor(tracks.view(i));
+                    }
+                }
+            );
+        }
+
+    private:
+        // Read-only mapping of the cache file
+        struct Mapping {
+            const char* data = nullptr;
+            std::size_t size = 0;
+
+            Mapping(const std::string& path) {
+                int fd = ::open(path.c_str(), O_RDONLY);
+                if (fd < 0) {
+                    throw std::invalid_argument("Cannot open " + path);
+                }
+                struct stat st;
+                if (::fstat(fd, &st) != 0) {
+                    ::close(fd);
+                    throw std::invalid_argument("Cannot stat " + path);
+                }
+                size = st.st_size;
+                void* ptr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+                ::close(fd);
+                if (ptr == MAP_FAILED) {
+                    throw std::invalid_argument("Cannot map " + path);
+                }
+                ::madvise(ptr, size, MADV_SEQUENTIAL);
+                data = static_cast<const char*>(ptr);
+            }
+
+            Mapping(const Mapping&) = delete;
+            Mapping& operator=(const Mapping&) = delete;
+
+            ~Mapping() {
+                ::munmap(const_cast<char*>(data), size);
+            }
+        };
+
+        Config m_cfg;
+
+        std::shared_ptr<const Mapping> m_mapping;
+
+        // Column name to its bytes in the mapping
+        std::unordered_map<std::string, std::span<const char>> m_columns;
+
+        // Stored column resolved once in the mapping,
+        // next to the member it is staged into
+        template <typename T>
+        struct ResolvedColumn {
+            std::vector<T> EventTracks::* member;
+            std::span<const T> values;
+        };
+        struct ResolvedHits {
+            HitColumns EventTracks::* member;
+            std::span<const std::uint64_t> offsets;
+            std::span<const double> x;
+            std::span<const double> y;
+            std::span<const double> z;
+        };
+        std::vector<ResolvedColumn<double>> m_doubleColumns;
+        std::vector<ResolvedColumn<int>> m_intColumns;
+        std::vector<ResolvedColumn<Vector3>> m_vector3Columns;
+        std::vector<ResolvedColumn<LorentzVector>> m_lorentzColumns;
+        std::vector<ResolvedHits> m_hitColumns;
+
+        // Stored post-processing flags of a skim
+        std::span<const std::uint8_t> m_isOverlap;
+        std::span<const std::uint8_t> m_isMultiple;
+        bool m_hasFlags = false;
+
+        // Track ranges of the events in file order
+        std::span<const EventRange> m_ranges;
+
+        // Event index and file list of the cache,
+        // shared by the handles
+        struct Index {
+            EventIndex index;
+            std::vector<std::string> filePaths;
+        };
+        std::shared_ptr<const Index> m_index;
+
+        // Event id to its range
+        std::unordered_map<std::uint32_t, std::size_t> m_eventIndex;
+
+        std::span<const double> m_matchingDegrees;
+
+        std::size_t m_nInputEvents = 0;
+
+        // Tracks of the current event, reused across events
+        EventTracks m_eventBuffer;
+
+        // Parse the header and the column directory
+        void prepareColumns() {
+            const auto& mapping = *m_mapping;
+            ColumnarLayout::Header header;
+            if (mapping.size < sizeof(header)) {
+                throw std::invalid_argument("Truncated cache " + m_cfg.filePath);
+            }
+            std::memcpy(&header, mapping.data, sizeof(header));
+            if (!std::equal(header.magic, header.magic + 8, ColumnarLayout::magic) ||
+                header.version != ColumnarLayout::version) {
+                    throw std::invalid_argument("Not a track cache " + m_cfg.filePath);
+            }
+            auto directoryEnd = sizeof(header) +
+                header.nColumns * sizeof(ColumnarLayout::ColumnEntry);
+            if (mapping.size < directoryEnd) {
+                throw std::invalid_argument("Truncated cache " + m_cfg.filePath);
+            }
+            for (std::uint32_t i = 0; i < header.nColumns; i++) {
+                ColumnarLayout::ColumnEntry entry;
+                std::memcpy(&entry,
+                    mapping.data + sizeof(header) + i * sizeof(entry), sizeof(entry));
+                if (entry.offset + entry.size > mapping.size) {
+                    throw std::invalid_argument("Truncated cache " + m_cfg.filePath);
+                }
+                entry.name[sizeof(entry.name) - 1] = '\0';
+                m_columns.emplace(entry.name,
+                    std::span<const char>(mapping.data + entry.offset, entry.size));
+            }
+
+            // Requested columns must have been
+            // converted into the cache
+            for (const auto& name : m_cfg.columns) {
+                if (!m_columns.contains(name) && !m_columns.contains(name + ".offsets")) {
+                    throw std::invalid_argument(
+                        "Missing " + name + " column in " + m_cfg.filePath);
+                }
+            }
+
+            resolveColumns(TreeColumns::doubleKeys, m_doubleColumns);
+            resolveColumns(TreeColumns::intKeys, m_intColumns);
+            resolveColumns(TreeColumns::vector3Keys, m_vector3Columns);
+            resolveColumns(TreeColumns::lorentzKeys, m_lorentzColumns);
+            for (const auto& [name, trackMember, member] : EventTracks::hitMembers) {
+                std::string base = name;
+                if (!isRead(name) || !m_columns.contains(base + ".offsets")) {
+                    continue;
+                }
+                m_hitColumns.push_back({
+                    member,
+                    column<std::uint64_t>(base + ".offsets"),
+                    column<double>(base + ".x"),
+                    column<double>(base + ".y"),
+                    column<double>(base + ".z")});
+            }
+
+            m_hasFlags =
+                m_columns.contains(SkimWriter::overlapBranch) &&
+                m_columns.contains(SkimWriter::multipleBranch);
+            if (m_hasFlags) {
+                m_isOverlap = column<std::uint8_t>(SkimWriter::overlapBranch);
+                m_isMultiple = column<std::uint8_t>(SkimWriter::multipleBranch);
+            }
+
+            m_ranges = column<EventRange>(ColumnarLayout::eventRanges);
+            m_nInputEvents = header.nInputEvents;
+            m_matchingDegrees = column<double>(ColumnarLayout::matchingDegrees);
+            m_eventIndex.reserve(m_ranges.size());
+            for (std::size_t i = 0; i < m_ranges.size(); i++) {
+                m_eventIndex.emplace(m_ranges[i].eventId, i);
+            }
+
+            auto index = std::make_shared<Index>();
+            index->index = EventIndex::forFile(m_cfg.filePath, ColumnarLayout::treeName);
+            index->index.nEntries = header.nTracks;
+            index->index.nInputEvents = header.nInputEvents;
+            index->index.ranges.assign(m_ranges.begin(), m_ranges.end());
+            index->index.matchingDegrees.assign(
+                m_matchingDegrees.begin(), m_matchingDegrees.end());
+            index->filePaths = {m_cfg.filePath};
+            m_index = index;
+        }
+
+        // Typed view of a column, empty if not stored
+        template <typename T>
+        std::span<const T> column(const std::string& name) const {
+            auto it = m_columns.find(name);
+            if (it == m_columns.end()) {
+                return {};
+            }
+            return {
+                reinterpret_cast<const T*>(it->second.data()),
+                it->second.size() / sizeof(T)};
+        }
+
+        // Check whether a column is read
+        bool isRead(const char* name) const {
+            return m_cfg.columns.empty() ||
+                std::ranges::find(m_cfg.columns, name) != m_cfg.columns.end();
+        }
+
+        // Resolve the read columns of a kind
+        //
+        // @par keys: columns of the kind and their members
+        // @par resolved: resolved columns to fill
+        template <typename T>
+        void resolveColumns(
+            const TreeColumns::Keys<std::vector<T>>& keys,
+            std::vector<ResolvedColumn<T>>& resolved) {
+                for (const auto& [name, member] : keys) {
+                    if (isRead(name) && m_columns.contains(name)) {
+                        resolved.push_back({member, column<T>(name)});
+                    }
+                }
+        }
+
+        // Stage the tracks of an event in the container
+        void readEvent(std::uint32_t eventN, EventTracks& tracks) {
+            ScopedTimer timer(Stage::ReadEvent);
+            tracks.clear();
+
+            auto it = m_eventIndex.find(eventN);
+            if (it == m_eventIndex.end()) {
+                return;
+            }
+            const auto& range = m_ranges[it->second];
+
+            auto copy = [&] (const auto& columns) {
+                for (const auto& [member, values] : columns) {
+                    (tracks.*member).assign(
+                        values.begin() + range.start, values.begin() + range.end);
+                }
+            };
+            copy(m_doubleColumns);
+            copy(m_intColumns);
+            copy(m_vector3Columns);
+            copy(m_lorentzColumns);
+
+            for (const auto& [member, offsets, x, y, z] : m_hitColumns) {
+                auto& hits = tracks.*member;
+                const auto first = offsets[range.start];
+                const auto last = offsets[range.end];
+                for (auto i = range.start + 1; i <= range.end; i++) {
+                    hits.offsets.push_back(offsets[i] - first);
+                }
+                hits.x.assign(x.begin() + first, x.begin() + last);
+                hits.y.assign(y.begin() + first, y.begin() + last);
+                hits.z.assign(z.begin() + first, z.begin() + last);
+            }
+            if (m_hasFlags) {
+                tracks.isOverlap.assign(
+                    m_isOverlap.begin() + range.start, m_isOverlap.begin() + range.end);
+                tracks.isMultiple.assign(
+                    m_isMultiple.begin() + range.start, m_isMultiple.begin() + range.end);
+            }
+            tracks.resize(range.end - range.start);
+            tracks.hasStoredFlags = m_hasFlags;
+        }
+};
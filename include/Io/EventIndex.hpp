@@ -0,0 +1,240 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+// Contiguous entry range of a single event
+struct EventRange {
+    /// Id of the event
+    std::uint32_t eventId;
+    /// First entry of the range
+    std::size_t start;
+    /// One past the last entry of the range
+    std::size_t end;
+};
+
+// Value bounds of a scalar column
+struct ColumnSummary {
+    /// Smallest value in the column
+    double min;
+    /// Largest value in the column
+    double max;
+};
+
+// Event index of a tree together with cheap
+// column summaries, persisted next to the input
+// file so that later runs can skip the scan
+struct EventIndex {
+    public:
+        /// Size of the indexed file in bytes
+        std::uintmax_t fileSize = 0;
+        /// Modification time of the indexed file
+        std::int64_t modTime = 0;
+        /// Name of the indexed tree
+        std::string treeName;
+
+        /// Number of entries in the tree
+        std::size_t nEntries = 0;
+
+        /// Entry ranges of the events in file order
+        std::vector<EventRange> ranges;
+
+        /// Bounds of the scalar columns
+        std::map<std::string, ColumnSummary> summaries;
+
+        /// Distinct matching degrees in ascending order
+        std::vector<double> matchingDegrees;
+
+        /// Number of events of the dataset a skim was
+        /// written from, 0 for a plain tree
+        std::size_t nInputEvents = 0;
+
+        // Default location of the index of a file
+        static std::string defaultPath(
+            const std::string& filePath, const std::string& treeName) {
+                return filePath + "." + treeName + ".idx";
+        }
+
+        // Create an empty index keyed by the current
+        // state of the file
+        static EventIndex forFile(
+            const std::string& filePath, const std::string& treeName) {
+                EventIndex index;
+                index.fileSize = std::filesystem::file_size(filePath);
+                index.modTime = std::filesystem::last_write_time(filePath)
+                    .time_since_epoch().count();
+                index.treeName = treeName;
+                return index;
+        }
+
+        // Check whether the index describes the same
+        // file and tree as the other one
+        bool matches(const EventIndex& other) const {
+            return fileSize == other.fileSize &&
+                modTime == other.modTime &&
+                treeName == other.treeName;
+        }
+
+        // Write the index to disk
+        //
+        // @par path: path of the index file
+        //
+        // @return: true if the index was written
+        bool write(const std::string& path) const {
+            // Write to a temporary file first so that
+            // concurrent jobs never see a partial index,
+            // and remove it if the write fails. The name
+            // is unique to the process and the thread so
+            // that concurrent writers never share it
+            std::string tmpPath = path + ".tmp." + 
+                std::to_string(::getpid()) + "." +
+                std::to_string(std::hash<std::thread::id>{}(
+                    std::this_thread::get_id()));
+            std::error_code ec;
+            {
+                std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+                if (!out) {
+                    std::filesystem::remove(tmpPath, ec);
+                    return false;
+                }
+                out.write(magic, sizeof(magic));
+                writeValue(out, version);
+
+                writeValue(out, fileSize);
+                writeValue(out, modTime);
+                writeString(out, treeName);
+
+                writeValue(out, nEntries);
+                writeVector(out, ranges);
+
+                writeValue(out, summaries.size());
+                for (const auto& [column, summary] : summaries) {
+                    writeString(out, column);
+                    writeValue(out, summary);
+                }
+                writeVector(out, matchingDegrees);
+                writeValue(out, nInputEvents);
+
+                out.close();
+                if (!out) {
+                    std::filesystem::remove(tmpPath, ec);
+                    return false;
+                }
+            }
+            std::filesystem::rename(tmpPath, path, ec);
+            if (ec) {
+                std::error_code removeEc;
+                std::filesystem::remove(tmpPath, removeEc);
+                return false;
+            }
+            return true;
+        }
+
+        // Read an index from disk
+        //
+        // @par path: path of the index file
+        //
+        // @return: the index, or nothing if the file
+        // is missing or malformed
+        static std::optional<EventIndex> read(const std::string& path) {
+            std::ifstream in(path, std::ios::binary);
+            if (!in) {
+                return std::nullopt;
+            }
+            // Sizes stored in the file can never exceed it
+            const std::size_t limit = std::filesystem::file_size(path);
+            char fileMagic[sizeof(magic)];
+            in.read(fileMagic, sizeof(magic));
+            std::uint32_t fileVersion = 0;
+            readValue(in, fileVersion);
+            if (!in ||
+                !std::equal(fileMagic, fileMagic + sizeof(magic), magic) ||
+                fileVersion != version) {
+                    return std::nullopt;
+            }
+
+            EventIndex index;
+            readValue(in, index.fileSize);
+            readValue(in, index.modTime);
+            readString(in, index.treeName, limit);
+
+            readValue(in, index.nEntries);
+            readVector(in, index.ranges, limit);
+
+            std::size_t nSummaries = 0;
+            readValue(in, nSummaries);
+            for (std::size_t i = 0; in && i < nSummaries; i++) {
+                std::string column;
+                ColumnSummary summary;
+                readString(in, column, limit);
+                readValue(in, summary);
+                index.summaries.emplace(column, summary);
+            }
+            readVector(in, index.matchingDegrees, limit);
+            readValue(in, index.nInputEvents);
+
+            if (!in) {
+                return std::nullopt;
+            }
+            return index;
+        }
+
+    private:
+        static constexpr char magic[8] = {'O', 'T', 'A', 'I', 'D', 'X', '\0', '\0'};
+        static constexpr std::uint32_t version = 2;
+
+        template <typename T>
+        static void writeValue(std::ofstream& out, const T& value) {
+            out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        template <typename T>
+        static void readValue(std::ifstream& in, T& value) {
+            in.read(reinterpret_cast<char*>(&value), sizeof(T));
+        }
+
+        static void writeString(std::ofstream& out, const std::string& str) {
+            writeValue(out, str.size());
+            out.write(str.data(), str.size());
+        }
+
+        static void readString(
+            std::ifstream& in, std::string& str, std::size_t limit) {
+            std::size_t size = 0;
+            readValue(in, size);
+            if (!in || size > limit) {
+                in.setstate(std::ios::failbit);
+                return;
+            }
+            str.resize(size);
+            in.read(str.data(), size);
+        }
+
+        template <typename T>
+        static void writeVector(std::ofstream& out, const std::vector<T>& v) {
+            writeValue(out, v.size());
+            out.write(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(T));
+        }
+
+        template <typename T>
+        static void readVector(
+            std::ifstream& in, std::vector<T>& v, std::size_t limit) {
+            std::size_t size = 0;
+            readValue(in, size);
+            if (!in || size > limit / sizeof(T)) {
+                in.setstate(std::ios::failbit);
+                return;
+            }
+            v.resize(size);
+            in.read(reinterpret_cast<char*>(v.data()), size * sizeof(T));
+        }
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <filesystem>
+#include <vector>
+
+// Extract the file paths from a directory
+inline std::vector<std::string> prepareFilePaths(const std::string& path) {
+    // Get the paths to the files in the directory
+    std::vector<std::string> filePaths;
+    for (const auto & entry : std::filesystem::directory_iterator(path)) {
+        // Skip sidecar index files and other non-ROOT files
+        if (!entry.is_regular_file() || entry.path().extension() != ".root") {
+            continue;
+        }
+        std::string pathToFile = entry.path();
+        filePaths.push_back(pathToFile);
+    }
+
+    // Sort the file paths by the BX number
+    std::sort(filePaths.begin(), filePaths.end(),
+        [] (const std::string& a, const std::string& b) {
+            std::size_t idxRootA = a.find_last_of('.');
+            std::size_t idxEventA = a.find_last_of('t', idxRootA);
+            std::string eventSubstrA = a.substr(idxEventA + 1, idxRootA - idxEventA);
+            
+            std::size_t idxRootB = b.find_last_of('.');
+            std::size_t idxEventB = b.find_last_of('t', idxRootB);
+            std::string eventSubstrB = b.substr(idxEventB + 1, idxRootB - idxEventB);
+
+            return std::stoul(eventSubstrA) < std::stoul(eventSubstrB);
+        }
+    );
+
+    return filePaths;
+}
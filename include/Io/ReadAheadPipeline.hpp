@@ -0,0 +1,190 @@
+#pragma once
+
+#include "include/Types/EventTracks.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Queue depth, batch size and number of
+// producers of a read-ahead pipeline
+struct ReadAheadConfig {
+    /// Number of batches decoded ahead
+    std::size_t queueDepth = 4;
+    /// Number of events per batch
+    std::size_t batchSize = 64;
+    /// Number of decoding threads, each
+    /// with its own reader handle
+    std::size_t nProducers = 1;
+};
+
+// Reader that decodes upcoming events on producer
+// threads while the caller analyzes the current ones
+//
+// Events are grouped into batches that travel through
+// a bounded ring of slots. Batch b always occupies slot
+// b % queueDepth, so producers never run more than the
+// ring ahead of the consumer and batches are consumed
+// strictly in order. The staged containers are swapped
+// with the reader buffers rather than copied, so their
+// allocations are recycled through the ring.
+template <typename Reader>
+class ReadAheadPipeline {
+    public:
+        using Config = ReadAheadConfig;
+
+        ReadAheadPipeline(const Reader& reader, const Config& cfg = Config())
+            : m_reader(reader), m_cfg(cfg) {
+                m_cfg.queueDepth = std::max<std::size_t>(m_cfg.queueDepth, 1);
+                m_cfg.batchSize = std::max<std::size_t>(m_cfg.batchSize, 1);
+                m_cfg.nProducers = std::max<std::size_t>(m_cfg.nProducers, 1);
+        }
+
+        // Visit the tracks of every event in file order
+        //
+        // @par visitor: callable taking the event id
+        // and the EventTracks& of the event
+        template <typename Visitor>
+        void forEachEvent(Visitor&& visitor) {
+            forEachEvent(m_reader.getEventsInFileOrder(), visitor);
+        }
+
+        // Visit the tracks of the given events in order
+        //
+        // The visitor runs on the calling thread, the
+        // tracks are only valid during the call
+        //
+        // @par events: ids of the events to visit
+        // @par visitor: callable taking the event id
+        // and the EventTracks& of the event
+        template <typename Visitor>
+        void forEachEvent(
+            const std::vector<std::uint32_t>& events, Visitor&& visitor) {
+                const std::size_t nBatches =
+                    (events.size() + m_cfg.batchSize - 1) / m_cfg.batchSize;
+                const std::size_t nProducers = std::clamp<std::size_t>(
+                    m_cfg.nProducers, 1, std::max<std::size_t>(nBatches, 1));
+
+                m_slots.resize(m_cfg.queueDepth);
+                for (std::size_t i = 0; i < m_slots.size(); i++) {
+                    m_slots.at(i).batch = i;
+                    m_slots.at(i).ready = false;
+                }
+                m_stop = false;
+                m_error = nullptr;
+
+                // Producer p decodes batches p, p + nProducers, ...
+                auto produce = [&] (std::size_t producer) {
+                    try {
+                        Reader reader(m_reader);
+                        for (auto b = producer; b < nBatches; b += nProducers) {
+                            auto& slot = m_slots.at(b % m_slots.size());
+                            {
+                                std::unique_lock<std::mutex> lock(m_mutex);
+                                m_cv.wait(lock,
+                                    [&] { return m_stop || slot.batch == b; });
+                                if (m_stop) {
+                                    return;
+                                }
+                            }
+                            // The slot belongs to this producer
+                            // until it is marked ready
+                            auto first = events.begin() + b * m_cfg.batchSize;
+                            auto last = events.begin() +
+                                std::min((b + 1) * m_cfg.batchSize, events.size());
+                            slot.events.assign(first, last);
+                            slot.tracks.resize(slot.events.size());
+                            std::size_t k = 0;
+                            reader.forEachEvent(slot.events,
+                                [&slot, &k] (std::uint32_t, EventTracks& tracks) {
+                                    std::swap(slot.tracks.at(k++), tracks);
+                                }
+                            );
+                            {
+                                std::lock_guard<std::mutex> lock(m_mutex);
+                                slot.ready = true;
+                            }
+                            m_cv.notify_all();
+                        }
+                    }
+                    catch (...) {
+                        stop(std::current_exception());
+                    }
+                };
+
+                std::vector<std::thread> producers;
+                for (std::size_t i = 0; i < nProducers; i++) {
+                    producers.emplace_back(produce, i);
+                }
+
+                try {
+                    for (std::size_t b = 0; b < nBatches; b++) {
+                        auto& slot = m_slots.at(b % m_slots.size());
+                        {
+                            std::unique_lock<std::mutex> lock(m_mutex);
+                            m_cv.wait(lock, [&] { return m_stop || slot.ready; });
+                            if (m_stop) {
+                                break;
+                            }
+                        }
+                        for (std::size_t k = 0; k < slot.events.size(); k++) {
+                            visitor(slot.events.at(k), slot.tracks.at(k));
+                        }
+                        {
+                            std::lock_guard<std::mutex> lock(m_mutex);
+                            slot.ready = false;
+                            slot.batch = b + m_slots.size();
+                        }
+                        m_cv.notify_all();
+                    }
+                }
+                catch (...) {
+                    stop(std::current_exception());
+                }
+
+                for (auto& producer : producers) {
+                    producer.join();
+                }
+                if (m_error) {
+                    std::rethrow_exception(m_error);
+                }
+        }
+
+    private:
+        // Ring slot holding one batch of events
+        struct Slot {
+            /// Batch allowed to occupy the slot
+            std::size_t batch = 0;
+            /// Batch is decoded and can be consumed
+            bool ready = false;
+
+            std::vector<std::uint32_t> events;
+            std::vector<EventTracks> tracks;
+        };
+
+        const Reader& m_reader;
+        Config m_cfg;
+
+        std::vector<Slot> m_slots;
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        bool m_stop = false;
+        std::exception_ptr m_error;
+
+        // Abort the pipeline, keeping the first error
+        void stop(std::exception_ptr error) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_error) {
+                    m_error = error;
+                }
+                m_stop = true;
+            }
+            m_cv.notify_all();
+        }
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Slice of the event index processed by one job
+// when a dataset is spread over several jobs
+struct Shard {
+    /// Index of the shard
+    std::size_t index = 0;
+    /// Number of shards
+    std::size_t count = 1;
+
+    // Parse a shard specification of the form i/N
+    static Shard parse(const std::string& spec) {
+        auto slash = spec.find('/');
+        if (slash == std::string::npos) {
+            throw std::invalid_argument("Shard must be given as i/N: " + spec);
+        }
+        Shard shard;
+        try {
+            shard.index = std::stoul(spec.substr(0, slash));
+            shard.count = std::stoul(spec.substr(slash + 1));
+        }
+        catch (const std::logic_error&) {
+            throw std::invalid_argument("Shard must be given as i/N: " + spec);
+        }
+        if (shard.count == 0 || shard.index >= shard.count) {
+            throw std::invalid_argument("Shard index out of range: " + spec);
+        }
+        return shard;
+    }
+
+    // Select the contiguous slice of the events 
+    // belonging to the shard, the slices of all 
+    // shards cover every event exactly once
+    //
+    // @par events: events in file order
+    std::vector<std::uint32_t> select(const std::vector<std::uint32_t>& events) const {
+        auto first = events.size() * index / count;
+        auto last = events.size() * (index + 1) / count;
+        return {events.begin() + first, events.begin() + last};
+    }
+};
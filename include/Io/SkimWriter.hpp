@@ -0,0 +1,256 @@
+#pragma once
+
+#include "include/Types/Track.hpp"
+#include "include/Types/EventTracks.hpp"
+#include "include/Types/TreeColumns.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "TFile.h"
+#include "TParameter.h"
+#include "TTree.h"
+#include "TVector3.h"
+#include "TLorentzVector.h"
+
+// Writer of a slimmed fitted-tracks tree
+//
+// The tree keeps the schema of the input for the
+// chosen columns and adds the isOverlap and isMultiple
+// flags of every track, which TrackTreeReader reads
+// in place of the post-processing. Tracks are written
+// event by event, so the events stay contiguous.
+// Without the flags the tree is read like a plain
+// fitted-tracks tree. Events without written tracks
+// are absent from the tree, the number of events of
+// the input is stored next to it for the cut flow
+// normalization.
+class SkimWriter {
+    public:
+        struct Config {
+            /// Path of the skim file
+            std::string filePath;
+            /// Name of the tree
+            std::string treeName = "fitted-tracks";
+            /// Columns to write, all columns
+            /// are written if empty
+            std::vector<std::string> columns = {};
+            /// ROOT compression setting, 100 times
+            /// the algorithm plus the level
+            int compression = 505;
+            /// Size of the branch baskets in bytes
+            int basketSize = 32000;
+            /// Flush the baskets every given number of
+            /// entries, or of bytes if negative
+            long long autoFlush = -30'000'000;
+            /// Store the post-processing flags, without
+            /// them the tree is a plain fitted-tracks tree
+            bool storeFlags = true;
+        };
+
+        /// Names of the stored post-processing flags
+        static constexpr const char* overlapBranch = "isOverlap";
+        static constexpr const char* multipleBranch = "isMultiple";
+
+        /// Name of the stored number of input events
+        static constexpr const char* inputEventsName = "nInputEvents";
+
+        SkimWriter(const Config& cfg) : m_cfg(cfg) {
+            m_file = std::make_unique<TFile>(cfg.filePath.c_str(), "RECREATE");
+            if (m_file->IsZombie()) {
+                throw std::invalid_argument("Cannot create " + cfg.filePath);
+            }
+            m_file->SetCompressionSettings(cfg.compression);
+
+            m_tree = new TTree(cfg.treeName.c_str(), cfg.treeName.c_str());
+            m_tree->SetDirectory(m_file.get());
+            m_tree->SetAutoFlush(cfg.autoFlush);
+
+            std::unordered_set<std::string_view> columns(
+                cfg.columns.begin(), cfg.columns.end());
+            columns.insert("eventId");
+            auto isWritten = [&] (const char* name) {
+                return cfg.columns.empty() || columns.contains(name);
+            };
+
+            std::size_t nKnown = 0;
+            auto select = [&] (auto& keys) {
+                std::erase_if(keys,
+                    [&] (const auto& key) {
+                        return !isWritten(key.first);
+                    }
+                );
+                nKnown += keys.size();
+            };
+            select(m_intKeys);
+            select(m_doubleKeys);
+            select(m_vector3Keys);
+            select(m_vVector3Keys);
+            select(m_lorentzKeys);
+            if (!cfg.columns.empty() && nKnown != columns.size()) {
+                throw std::invalid_argument("Unknown column requested");
+            }
+
+            // Buffers never move once the branches point to them
+            m_ints.resize(m_intKeys.size());
+            m_doubles.resize(m_doubleKeys.size());
+            m_vector3s.resize(m_vector3Keys.size());
+            m_vVector3s.resize(m_vVector3Keys.size());
+            m_lorentzs.resize(m_lorentzKeys.size());
+
+            const int basketSize = cfg.basketSize;
+            for (std::size_t k = 0; k < m_intKeys.size(); k++) {
+                const std::string leaf = std::string(m_intKeys[k].first) + "/I";
+                m_tree->Branch(m_intKeys[k].first, &m_ints[k], leaf.c_str(), basketSize);
+            }
+            for (std::size_t k = 0; k < m_doubleKeys.size(); k++) {
+                const std::string leaf = std::string(m_doubleKeys[k].first) + "/D";
+                m_tree->Branch(m_doubleKeys[k].first, &m_doubles[k], leaf.c_str(), basketSize);
+            }
+            for (std::size_t k = 0; k < m_vector3Keys.size(); k++) {
+                m_vector3s[k] = new TVector3();
+                m_tree->Branch(m_vector3Keys[k].first, &m_vector3s[k], basketSize);
+            }
+            for (std::size_t k = 0; k < m_vVector3Keys.size(); k++) {
+                m_vVector3s[k] = new std::vector<TVector3>();
+                m_tree->Branch(m_vVector3Keys[k].first, &m_vVector3s[k], basketSize);
+            }
+            for (std::size_t k = 0; k < m_lorentzKeys.size(); k++) {
+                m_lorentzs[k] = new TLorentzVector();
+                m_tree->Branch(m_lorentzKeys[k].first, &m_lorentzs[k], basketSize);
+            }
+            if (cfg.storeFlags) {
+                m_tree->Branch(overlapBranch, &m_isOverlap, "isOverlap/O", basketSize);
+                m_tree->Branch(multipleBranch, &m_isMultiple, "isMultiple/O", basketSize);
+            }
+        }
+
+        SkimWriter(const SkimWriter&) = delete;
+        SkimWriter& operator=(const SkimWriter&) = delete;
+
+        ~SkimWriter() {
+            close();
+            for (auto* value : m_vector3s) {
+                delete value;
+            }
+            for (auto* value : m_vVector3s) {
+                delete value;
+            }
+            for (auto* value : m_lorentzs) {
+                delete value;
+            }
+        }
+
+        // Write the selected tracks of an event, called
+        // for every input event, also without selected tracks
+        //
+        // @par tracks: tracks of the event, with the
+        // overlap and multiplicity flags set if stored
+        // @par selected: indices of the tracks to write
+        void write(const EventTracks& tracks, std::span<const std::uint32_t> selected) {
+            if (!m_tree) {
+                throw std::logic_error("Writing to a closed skim");
+            }
+            for (auto i : selected) {
+                for (std::size_t k = 0; k < m_intKeys.size(); k++) {
+                    m_ints[k] = (tracks.*m_intKeys[k].second).at(i);
+                }
+                for (std::size_t k = 0; k < m_doubleKeys.size(); k++) {
+                    m_doubles[k] = (tracks.*m_doubleKeys[k].second).at(i);
+                }
+                for (std::size_t k = 0; k < m_vector3Keys.size(); k++) {
+                    const auto& value = (tracks.*m_vector3Keys[k].second).at(i);
+                    m_vector3s[k]->SetXYZ(value.x, value.y, value.z);
+                }
+                for (std::size_t k = 0; k < m_vVector3Keys.size(); k++) {
+                    const auto& hits = tracks.*m_vVector3Keys[k].second;
+                    auto& value = *m_vVector3s[k];
+                    value.clear();
+                    for (auto hit = hits.offsets.at(i); hit < hits.offsets.at(i + 1); hit++) {
+                        value.emplace_back(hits.x[hit], hits.y[hit], hits.z[hit]);
+                    }
+                }
+                for (std::size_t k = 0; k < m_lorentzKeys.size(); k++) {
+                    const auto& value = (tracks.*m_lorentzKeys[k].second).at(i);
+                    m_lorentzs[k]->SetPxPyPzE(value.px, value.py, value.pz, value.e);
+                }
+                if (m_cfg.storeFlags) {
+                    m_isOverlap = tracks.isOverlap.at(i);
+                    m_isMultiple = tracks.isMultiple.at(i);
+                }
+
+                m_tree->Fill();
+                m_nWritten++;
+            }
+            m_nEvents++;
+        }
+
+        // Set the number of input events, by default
+        // the number of events passed to write
+        //
+        // @par nEvents: number of events of the dataset
+        // the input was skimmed from, if it is a skim
+        void setInputEvents(std::size_t nEvents) {
+            m_nInputEvents = nEvents;
+        }
+
+        // Write the tree and close the file
+        void close() {
+            if (!m_tree) {
+                return;
+            }
+            m_file->cd();
+            m_tree->Write();
+            TParameter<double>(inputEventsName, 
+                m_nInputEvents.value_or(m_nEvents)).Write();
+            m_file->Close();
+            m_tree = nullptr;
+        }
+
+        // Number of written tracks
+        std::size_t nWritten() const {
+            return m_nWritten;
+        }
+
+    private:
+        Config m_cfg;
+
+        std::unique_ptr<TFile> m_file;
+
+        // Owned by the file
+        TTree* m_tree = nullptr;
+
+        std::size_t m_nWritten = 0;
+
+        /// Number of events passed to write
+        /// and of events of the input
+        std::size_t m_nEvents = 0;
+        std::optional<std::size_t> m_nInputEvents;
+
+        // Branch buffers of the written columns
+        std::vector<std::int32_t> m_ints;
+        std::vector<double> m_doubles;
+        std::vector<TVector3*> m_vector3s;
+        std::vector<std::vector<TVector3>*> m_vVector3s;
+        std::vector<TLorentzVector*> m_lorentzs;
+        bool m_isOverlap = false;
+        bool m_isMultiple = false;
+
+        // Columns of the tree and the
+        // event columns they are taken from
+        template <typename T>
+        using ColumnKeys = TreeColumns::Keys<T>;
+
+        ColumnKeys<std::vector<int>> m_intKeys = TreeColumns::intKeys;
+        ColumnKeys<std::vector<double>> m_doubleKeys = TreeColumns::doubleKeys;
+        ColumnKeys<std::vector<Vector3>> m_vector3Keys = TreeColumns::vector3Keys;
+        ColumnKeys<HitColumns> m_vVector3Keys = TreeColumns::hitKeys;
+        ColumnKeys<std::vector<LorentzVector>> m_lorentzKeys = TreeColumns::lorentzKeys;
+};
@@ -0,0 +1,234 @@
+#pragma once
+
+#include "include/Types/EventTracks.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Generator of synthetic events with every column
+// of the fitted-tracks tree
+//
+// Tracks are straight lines through equidistant
+// layers with Gaussian measurement and fit errors,
+// momenta along y and a chi2 distributed with the
+// ndf of the track. Every event is generated from
+// the seed and its id alone, so the events do not
+// depend on the order they are generated in.
+class SyntheticTracks {
+    public:
+        struct Config {
+            /// Mean number of tracks per event
+            double meanTracks = 10;
+            /// Draw the number of tracks from a Poisson
+            /// distribution, or use the mean for every event
+            bool poissonTracks = true;
+            /// Number of hits per track, one per layer
+            std::size_t nHits = 4;
+            /// Matching degrees and their relative weights
+            std::vector<std::pair<double, double>> matchingDegrees = {
+                {0.5, 1}, {1.0, 1}};
+            /// Probability of a track to take a hit
+            /// from an earlier track of the event
+            double sharedHitRate = 0.05;
+            /// Seed of the generator
+            std::uint32_t seed = 1;
+        };
+
+        SyntheticTracks(const Config& cfg) : m_cfg(cfg) {
+            if (cfg.nHits == 0) {
+                throw std::invalid_argument("Tracks need at least one hit");
+            }
+            if (cfg.meanTracks < 0) {
+                throw std::invalid_argument("Negative mean number of tracks");
+            }
+            if (cfg.poissonTracks && cfg.meanTracks == 0) {
+                throw std::invalid_argument("Poisson mean number of tracks must be positive");
+            }
+            if (cfg.sharedHitRate < 0 || cfg.sharedHitRate > 1) {
+                throw std::invalid_argument("Shared hit rate out of [0, 1]");
+            }
+            if (cfg.matchingDegrees.empty()) {
+                throw std::invalid_argument("No matching degrees given");
+            }
+            std::vector<double> weights;
+            for (auto [degree, weight] : cfg.matchingDegrees) {
+                if (weight < 0) {
+                    throw std::invalid_argument("Negative matching degree weight");
+                }
+                weights.push_back(weight);
+            }
+            m_degrees = std::discrete_distribution<std::size_t>(
+                weights.begin(), weights.end());
+        }
+
+        const Config& getConfig() const {
+            return m_cfg;
+        }
+
+        // Generate the tracks of an event
+        //
+        // @par eventId: id of the event, ids start at 1
+        // @par tracks: container the tracks are staged in
+        void generate(std::uint32_t eventId, EventTracks& tracks) {
+            tracks.clear();
+
+            std::seed_seq seq{m_cfg.seed, eventId};
+            std::mt19937_64 rng(seq);
+
+            std::size_t nTracks = std::llround(m_cfg.meanTracks);
+            if (m_cfg.poissonTracks) {
+                nTracks = std::poisson_distribution<std::size_t>(m_cfg.meanTracks)(rng);
+            }
+            const int ndf = 2 * m_cfg.nHits;
+            std::chi_squared_distribution<double> chi2(ndf);
+
+            for (std::size_t i = 0; i < nTracks; i++) {
+                tracks.matchingDegree.push_back(
+                    m_cfg.matchingDegrees.at(m_degrees(rng)).first);
+                tracks.ndf.push_back(ndf);
+                tracks.chi2.push_back(chi2(rng));
+                tracks.trackId.push_back(i);
+                tracks.eventId.push_back(eventId);
+
+                // Electrons from the interaction point
+                // moving along y
+                const double energy = uniform(rng, 1.5, 4.5);
+                const double pxTruth = normal(rng, 0, 0.005);
+                const double pzTruth = normal(rng, 0, 0.003);
+                const double pyTruth = std::sqrt(
+                    energy * energy - pxTruth * pxTruth - pzTruth * pzTruth);
+                tracks.ipMomentumTruth.push_back({pxTruth, pyTruth, pzTruth, energy});
+
+                const double px = pxTruth + normal(rng, 0, 0.01);
+                const double py = pyTruth * (1 + normal(rng, 0, 0.01));
+                const double pz = pzTruth + normal(rng, 0, 0.005);
+                tracks.ipMomentum.push_back(
+                    {px, py, pz, std::sqrt(px * px + py * py + pz * pz)});
+                tracks.ipMomentumError.push_back({0.002, 0.002, 0.01 * energy});
+
+                const Vector3 vertexTruth{normal(rng, 0, 0.01), 0, normal(rng, 0, 0.01)};
+                tracks.vertexTruth.push_back(vertexTruth);
+                tracks.vertex.push_back({
+                    vertexTruth.x + normal(rng, 0, 0.05),
+                    0,
+                    vertexTruth.z + normal(rng, 0, 0.05)});
+                tracks.vertexError.push_back({0.05, 0.05, 0.05});
+
+                generateHits(rng, tracks);
+            }
+            tracks.resize(nTracks);
+        }
+
+    private:
+        Config m_cfg;
+
+        std::discrete_distribution<std::size_t> m_degrees;
+
+        /// Distance between the layers
+        static constexpr double layerSpacing = 100;
+
+        /// Hit resolution and resolution
+        /// of the fitted positions
+        static constexpr double hitSigma = 0.05;
+        static constexpr double fitSigma = 0.03;
+
+        static double uniform(std::mt19937_64& rng, double low, double high) {
+            return std::uniform_real_distribution<double>(low, high)(rng);
+        }
+
+        static double normal(std::mt19937_64& rng, double mean, double sigma) {
+            return std::normal_distribution<double>(mean, sigma)(rng);
+        }
+
+        // Append the hit columns of a track
+        void generateHits(std::mt19937_64& rng, EventTracks& tracks) const {
+            const double x0 = uniform(rng, -20, 20);
+            const double y0 = uniform(rng, 0, 200);
+            const double dx = normal(rng, 0, 0.5);
+            const double dy = normal(rng, 0, 2);
+
+            // Hit shared with an earlier track of the event
+            const std::size_t track = tracks.trackHits.offsets.size() - 1;
+            std::size_t sharedLayer = m_cfg.nHits;
+            std::size_t sharedTrack = 0;
+            if (track > 0 && uniform(rng, 0, 1) < m_cfg.sharedHitRate) {
+                sharedLayer = std::uniform_int_distribution<std::size_t>(
+                    0, m_cfg.nHits - 1)(rng);
+                sharedTrack = std::uniform_int_distribution<std::size_t>(
+                    0, track - 1)(rng);
+            }
+
+            for (std::size_t layer = 0; layer < m_cfg.nHits; layer++) {
+                Vector3 truth{x0 + dx * layer, y0 + dy * layer, layerSpacing * (layer + 1)};
+                Vector3 hit{
+                    truth.x + normal(rng, 0, hitSigma),
+                    truth.y + normal(rng, 0, hitSigma),
+                    truth.z};
+                if (layer == sharedLayer) {
+                    auto idx = tracks.trackHits.offsets.at(sharedTrack) + layer;
+                    truth = {tracks.trueTrackHits.x.at(idx),
+                        tracks.trueTrackHits.y.at(idx), tracks.trueTrackHits.z.at(idx)};
+                    hit = {tracks.trackHits.x.at(idx),
+                        tracks.trackHits.y.at(idx), tracks.trackHits.z.at(idx)};
+                }
+                push(tracks.trueTrackHits, truth);
+                push(tracks.trackHits, hit);
+
+                // Predicted, filtered and smoothed estimates
+                // of the fit, each closer to the hit
+                const std::array<HitColumns EventTracks::*, 3> estimates = {
+                    &EventTracks::predictedTrackHits,
+                    &EventTracks::filteredTrackHits,
+                    &EventTracks::smoothedTrackHits};
+                const std::array<HitColumns EventTracks::*, 3> trueResiduals = {
+                    &EventTracks::truePredictedResiduals,
+                    &EventTracks::trueFilteredResiduals,
+                    &EventTracks::trueSmoothedResiduals};
+                const std::array<HitColumns EventTracks::*, 3> residuals = {
+                    &EventTracks::predictedResiduals,
+                    &EventTracks::filteredResiduals,
+                    &EventTracks::smoothedResiduals};
+                const std::array<HitColumns EventTracks::*, 3> truePulls = {
+                    &EventTracks::truePredictedPulls,
+                    &EventTracks::trueFilteredPulls,
+                    &EventTracks::trueSmoothedPulls};
+                const std::array<HitColumns EventTracks::*, 3> pulls = {
+                    &EventTracks::predictedPulls,
+                    &EventTracks::filteredPulls,
+                    &EventTracks::smoothedPulls};
+                for (std::size_t k = 0; k < estimates.size(); k++) {
+                    const double sigma = fitSigma * (3 - k);
+                    const double residualSigma = std::hypot(hitSigma, sigma);
+                    const Vector3 estimate{
+                        truth.x + normal(rng, 0, sigma),
+                        truth.y + normal(rng, 0, sigma),
+                        truth.z};
+                    const Vector3 trueResidual{
+                        truth.x - estimate.x, truth.y - estimate.y, 0};
+                    const Vector3 residual{
+                        hit.x - estimate.x, hit.y - estimate.y, 0};
+
+                    push(tracks.*estimates[k], estimate);
+                    push(tracks.*trueResiduals[k], trueResidual);
+                    push(tracks.*residuals[k], residual);
+                    push(tracks.*truePulls[k],
+                        {trueResidual.x / sigma, trueResidual.y / sigma, 0});
+                    push(tracks.*pulls[k],
+                        {residual.x / residualSigma, residual.y / residualSigma, 0});
+                }
+            }
+            for (auto [name, member, column] : EventTracks::hitMembers) {
+                (tracks.*column).endTrack();
+            }
+        }
+
+        static void push(HitColumns& hits, const Vector3& hit) {
+            hits.push(hit.x, hit.y, hit.z);
+        }
+};
@@ -1,115 +1,320 @@
 #pragma once
 
 #include "include/Types/Track.hpp"
+#include "include/Types/EventTracks.hpp"
+#include "include/Types/TreeColumns.hpp"
+#include "include/Io/EventIndex.hpp"
+#include "include/Io/FilePaths.hpp"
+#include "include/Io/SkimWriter.hpp"
+#include "include/detail/Profiler.hpp"
 
+#include <algorithm>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "TFile.h"  
 #include "TTree.h"
+#include "TChain.h"
+#include "TParameter.h"
 #include "TVector3.h"
+#include "TLorentzVector.h"
 
 // Chain manager that performs the setup of the TTree
+// over a single file or a dataset of files
 struct TrackTreeReader {
     public:
         struct Config {
-            /// File path to get the tree from
+            /// File path to get the tree from, or a 
+            /// directory of per-BX files forming the dataset
             std::string filePath;
+            /// Files forming the dataset, takes 
+            /// precedence over the file path
+            std::vector<std::string> filePaths = {};
             /// Name of the tree
             std::string treeName = "fitted-tracks";
+            /// Columns to read, all columns
+            /// are read if empty
+            std::vector<std::string> columns = {};
+            /// Size of the tree read cache in bytes
+            long long cacheSize = 100'000'000;
+            /// Load the event index from the sidecar
+            /// file and write it there after a scan
+            bool useIndexCache = true;
+            /// Path of the sidecar index file for a single
+            /// file dataset, defaults to the file path 
+            /// with an .idx suffix
+            std::string indexPath = "";
         };
 
         TrackTreeReader(const Config& cfg) : m_cfg(cfg) {
-            prepareTree(m_cfg.filePath);
+            prepareDataset();
+            prepareTree();
         }
 
-        // Get the list of events
+        // Open an independent handle on the same dataset,
+        // sharing the already built event index
+        TrackTreeReader(const TrackTreeReader& other) : 
+            m_cfg(other.m_cfg),
+            m_filePaths(other.m_filePaths),
+            m_fileOffsets(other.m_fileOffsets),
+            m_index(other.m_index),
+            m_eventIndex(other.m_eventIndex),
+            m_nextRange(other.m_nextRange) {
+                prepareTree();
+        }
+
+        TrackTreeReader& operator=(const TrackTreeReader&) = delete;
+
+        ~TrackTreeReader() {
+            delete m_tree;
+        }
+
+        // Get the sorted list of events
         std::vector<std::uint32_t> getEvents() const {
             std::vector<std::uint32_t> events;
-            for (auto& event : m_eventMap) {
-                events.push_back(std::get<0>(event));
+            events.reserve(m_eventIndex.size());
+            for (auto& [eventId, rangeIdx] : m_eventIndex) {
+                events.push_back(eventId);
+            }
+            std::sort(events.begin(), events.end());
+            return events;
+        }
+
+        // Get the list of events in the order of 
+        // their first entry in the file
+        std::vector<std::uint32_t> getEventsInFileOrder() const {
+            std::vector<std::uint32_t> events;
+            events.reserve(m_eventIndex.size());
+            for (std::size_t i = 0; i < m_index.ranges.size(); i++) {
+                const auto eventId = m_index.ranges.at(i).eventId;
+                if (m_eventIndex.at(eventId) == i) {
+                    events.push_back(eventId);
+                }
+            }
+            return events;
+        }
+
+        // Get the configuration of the reader
+        const Config& getConfig() const {
+            return m_cfg;
+        }
+
+        // Get the files forming the dataset
+        const std::vector<std::string>& getFilePaths() const {
+            return m_filePaths;
+        }
+
+        // Get the list of events whose first entry 
+        // is in the given file, in file order
+        std::vector<std::uint32_t> getEventsInFile(std::size_t fileIdx) const {
+            std::vector<std::uint32_t> events;
+            const auto first = m_fileOffsets.at(fileIdx);
+            const auto last = m_fileOffsets.at(fileIdx + 1);
+            for (std::size_t i = 0; i < m_index.ranges.size(); i++) {
+                const auto& range = m_index.ranges.at(i);
+                if (range.start < first || range.start >= last) {
+                    continue;
+                }
+                if (m_eventIndex.at(range.eventId) == i) {
+                    events.push_back(range.eventId);
+                }
             }
             return events;
         }
 
+        // Get the entry ranges of the events in file order
+        const std::vector<EventRange>& getEventRanges() const {
+            return m_index.ranges;
+        }
+
+        // Get the event index with the column summaries
+        const EventIndex& getIndex() const {
+            return m_index;
+        }
+
+        // Get the distinct matching degrees of the tracks
+        const std::vector<double>& getMatchingDegrees() const {
+            return m_index.matchingDegrees;
+        }
+
+        // Get the number of events of the dataset, for a 
+        // skim the events of the input it was written from,
+        // including the ones without written tracks
+        std::size_t getInputEvents() const {
+            if (m_index.nInputEvents > 0) {
+                return m_index.nInputEvents;
+            }
+            return m_eventIndex.size();
+        }
+
+        // Check whether the tracks carry the stored
+        // post-processing flags of a skim
+        bool hasStoredFlags() const {
+            return m_hasFlags;
+        }
+
+        // Get the value bounds of a scalar column
+        std::optional<ColumnSummary> getColumnSummary(const std::string& column) const {
+            auto it = m_index.summaries.find(column);
+            if (it == m_index.summaries.end()) {
+                return std::nullopt;
+            }
+            return it->second;
+        }
+
+        // Get the number of entries in the tree
+        std::size_t getEntries() const {
+            return m_index.nEntries;
+        }
+
         // Extract all tracks
+        //
+        // Prefer forEachEvent or forEachTrack, this
+        // keeps every track of the dataset in memory
         std::vector<Track> getTracks() {
             std::vector<Track> tracks;
-            for (auto& event : m_eventMap) {
-                auto eventTracks = getTracksForEvent(std::get<0>(event));
-                tracks.insert(tracks.end(), eventTracks.begin(), eventTracks.end());
-            }
+            forEachEvent(
+                [&tracks] (std::uint32_t, EventTracks& eventTracks) {
+                    for (std::size_t i = 0; i < eventTracks.size(); i++) {
+                        tracks.push_back(eventTracks.view(i).materialize());
+                    }
+                }
+            );
             return tracks;
         }
 
         // Extract tracks for a specific event
         std::vector<Track> getTracksForEvent(std::uint32_t eventN) {
+            readEvent(eventN, m_eventBuffer);
+            
             std::vector<Track> tracks;
-            auto it = std::find_if(m_eventMap.begin(), m_eventMap.end(),
-                [eventN] (const auto& a) {
-                    return std::get<0>(a) == eventN;
+            tracks.reserve(m_eventBuffer.size());
+            for (std::size_t i = 0; i < m_eventBuffer.size(); i++) {
+                tracks.push_back(m_eventBuffer.view(i).materialize());
+            }
+            return tracks;
+        }
+
+        // Visit the tracks of every event in file order
+        //
+        // The tracks are staged in a container reused 
+        // across events and only valid during the call
+        //
+        // @par visitor: callable taking the event id
+        // and the EventTracks& of the event
+        template <typename Visitor>
+        void forEachEvent(Visitor&& visitor) {
+            forEachEvent(getEventsInFileOrder(), visitor);
+        }
+
+        // Visit the tracks of the given events in order
+        //
+        // @par events: ids of the events to visit
+        // @par visitor: callable taking the event id
+        // and the EventTracks& of the event
+        template <typename Visitor>
+        void forEachEvent(
+            const std::vector<std::uint32_t>& events, Visitor&& visitor) {
+                for (auto eventId : events) {
+                    readEvent(eventId, m_eventBuffer);
+                    visitor(eventId, m_eventBuffer);
+                }
+        }
+
+        // Visit every track in file order
+        //
+        // @par visitor: callable taking a const TrackView&
+        template <typename Visitor>
+        void forEachTrack(Visitor&& visitor) {
+            forEachEvent(
+                [&visitor] (std::uint32_t, const EventTracks& tracks) {
+                    for (std::size_t i = 0; i < tracks.size(); i++) {
+                        visitor(tracks.view(i));
+                    }
                 }
             );
-            if (it == m_eventMap.end() || eventN == 0) {
-                return tracks;
+        }
+
+    private:
+        // Stage the tracks of an event in the container,
+        // reusing the allocations already made in it
+        void readEvent(std::uint32_t eventN, EventTracks& tracks) {
+            ScopedTimer timer(Stage::ReadEvent);
+            tracks.clear();
+
+            auto it = m_eventIndex.find(eventN);
+            if (it == m_eventIndex.end() || eventN == 0) {
+                return;
             }
-            auto start = std::get<1>(*it);
-            auto end = std::get<2>(*it);
-            
-            for (auto i = start; i < end; ++i) {
-                m_tree->GetEntry(i);
-                Track track;
-                
-                track.trueTrackHits = *m_vVector3Columns.at("trueTrackHits");
-                track.trackHits = *m_vVector3Columns.at("trackHits");
-                
-                track.predictedTrackHits = *m_vVector3Columns.at("predictedTrackHits"); 
-                track.filteredTrackHits = *m_vVector3Columns.at("filteredTrackHits"); 
-                track.smoothedTrackHits = *m_vVector3Columns.at("smoothedTrackHits"); 
-                
-                track.truePredictedResiduals = *m_vVector3Columns.at("truePredictedResiduals"); 
-                track.trueFilteredResiduals = *m_vVector3Columns.at("trueFilteredResiduals"); 
-                track.trueSmoothedResiduals = *m_vVector3Columns.at("trueSmoothedResiduals"); 
-                
-                track.predictedResiduals = *m_vVector3Columns.at("predictedResiduals"); 
-                track.filteredResiduals = *m_vVector3Columns.at("filteredResiduals"); 
-                track.smoothedResiduals = *m_vVector3Columns.at("smoothedResiduals"); 
-                
-                track.truePredictedPulls = *m_vVector3Columns.at("truePredictedPulls"); 
-                track.trueFilteredPulls = *m_vVector3Columns.at("trueFilteredPulls"); 
-                track.trueSmoothedPulls = *m_vVector3Columns.at("trueSmoothedPulls"); 
-                
-                track.predictedPulls = *m_vVector3Columns.at("predictedPulls"); 
-                track.filteredPulls = *m_vVector3Columns.at("filteredPulls"); 
-                track.smoothedPulls = *m_vVector3Columns.at("smoothedPulls"); 
-                
-                track.chi2 = m_doubleColumns.at("chi2");
-                track.matchingDegree = m_doubleColumns.at("matchingDegree");
-                
-                track.ndf = m_intColumns.at("ndf");
-                track.trackId = m_intColumns.at("trackId");
-                track.eventId = m_intColumns.at("eventId");
-                
-                track.ipMomentum = *m_lorentzColumns.at("ipMomentum");
-                track.ipMomentumTruth = *m_lorentzColumns.at("ipMomentumTruth");
-
-                track.vertex = *m_vector3Columns.at("vertex"); 
-                track.vertexTruth = *m_vector3Columns.at("vertexTruth"); 
-
-                track.ipMomentumError = *m_vector3Columns.at("ipMomentumError"); 
-                track.vertexError = *m_vector3Columns.at("vertexError"); 
-
-                tracks.push_back(track);
+            // Decompression and copy of the entries
+            // alternate, so their times are summed
+            const bool profile = Profiler::isEnabled();
+            Profiler::Clock::duration readTime{0};
+            Profiler::Clock::duration copyTime{0};
+            std::uint64_t nBytes = 0;
+
+            // Walk all the entry ranges of the event
+            std::size_t nTracks = 0;
+            for (auto idx = it->second; idx != noRange; idx = m_nextRange.at(idx)) {
+                const auto& range = m_index.ranges.at(idx);
+                for (auto i = range.start; i < range.end; ++i) {
+                    Profiler::Clock::time_point start;
+                    if (profile) {
+                        start = Profiler::Clock::now();
+                    }
+                    const int bytes = m_tree->GetEntry(i);
+                    if (profile) {
+                        auto read = Profiler::Clock::now();
+                        readTime += read - start;
+                        start = read;
+                        nBytes += std::max(bytes, 0);
+                    }
+
+                    // Only the enabled columns are filled,
+                    // the rest get default values below
+                    appendColumns(tracks, m_intKeys, m_intColumns);
+                    appendColumns(tracks, m_doubleKeys, m_doubleColumns);
+
+                    appendColumns(tracks, m_vector3Keys, m_vector3Columns);
+                    appendColumns(tracks, m_vVector3Keys, m_vVector3Columns);
+
+                    appendColumns(tracks, m_lorentzKeys, m_lorentzColumns);
+
+                    if (m_hasFlags) {
+                        tracks.isOverlap.push_back(m_isOverlap);
+                        tracks.isMultiple.push_back(m_isMultiple);
+                    }
+                    if (profile) {
+                        copyTime += Profiler::Clock::now() - start;
+                    }
+                    nTracks++;
+                }
             }
-            return tracks;
+            if (profile) {
+                Profiler::add(Stage::GetEntry, readTime, nTracks, nBytes);
+                Profiler::add(Stage::CopyColumns, copyTime, nTracks);
+            }
+            tracks.resize(nTracks);
+            tracks.hasStoredFlags = m_hasFlags;
         }
 
-    private:
         Config m_cfg;
 
-        // File pointer
-        TFile* m_file = nullptr;
+        // Files of the dataset
+        std::vector<std::string> m_filePaths;
+
+        // First global entry of every file,
+        // followed by the total entry count
+        std::vector<std::size_t> m_fileOffsets;
 
-        // Tree pointer
+        // Chain of the dataset files
         TTree* m_tree = nullptr;
 
         // Column containers
@@ -126,48 +331,122 @@ struct TrackTreeReader {
 
         std::unordered_map<std::string_view,
             TLorentzVector*> m_lorentzColumns;
+
+        // The tree is a skim with the stored
+        // overlap and multiplicity flags
+        bool m_hasFlags = false;
+        bool m_isOverlap = false;
+        bool m_isMultiple = false;
     
-        // Event map
-        std::vector<std::tuple<
-            std::uint32_t, std::size_t, std::size_t>> m_eventMap;
-
-        // Columns of the chain
-        std::vector<const char*> m_intKeys = {
-            "trackId", "eventId", "ndf"};
-        std::vector<const char*> m_doubleKeys = {
-            "chi2", "matchingDegree"};
-        std::vector<const char*> m_vector3Keys = {
-            "ipMomentumError",
-            "vertex",
-            "vertexError",
-            "vertexTruth"};
-        std::vector<const char*> m_vVector3Keys = {
-            "trueTrackHits",
-            "trackHits",
-            "predictedTrackHits",
-            "filteredTrackHits",
-            "smoothedTrackHits",
-            "truePredictedResiduals",
-            "trueFilteredResiduals",
-            "trueSmoothedResiduals",
-            "predictedResiduals",
-            "filteredResiduals",
-            "smoothedResiduals",
-            "truePredictedPulls",
-            "trueFilteredPulls",
-            "trueSmoothedPulls",
-            "predictedPulls",
-            "filteredPulls",
-            "smoothedPulls"};
-        std::vector<const char*> m_lorentzKeys = {
-            "ipMomentum",
-            "ipMomentumTruth"};
-
-        // Prepare the tree for reading
-        void prepareTree(std::string& filePath) {
-            // Open the file and get the tree
-            m_file = new TFile(filePath.c_str(), "READ");
-            m_tree = (TTree*)m_file->Get(m_cfg.treeName.c_str());
+        // Tracks of the current event, reused across events
+        EventTracks m_eventBuffer;
+
+        // Marker of the last range of an event
+        static constexpr std::size_t noRange = 
+            std::numeric_limits<std::size_t>::max();
+
+        // Entry ranges and column summaries 
+        // of the whole dataset
+        EventIndex m_index;
+
+        // Event id to the first range of the event
+        std::unordered_map<std::uint32_t, std::size_t> m_eventIndex;
+
+        // Next range of the same event, if the
+        // event is split across the file
+        std::vector<std::size_t> m_nextRange;
+
+        // Columns of the chain and the
+        // event columns they are stored in
+        template <typename T>
+        using ColumnKeys = TreeColumns::Keys<T>;
+
+        ColumnKeys<std::vector<int>> m_intKeys = TreeColumns::intKeys;
+        ColumnKeys<std::vector<double>> m_doubleKeys = TreeColumns::doubleKeys;
+        ColumnKeys<std::vector<Vector3>> m_vector3Keys = TreeColumns::vector3Keys;
+        ColumnKeys<HitColumns> m_vVector3Keys = TreeColumns::hitKeys;
+        ColumnKeys<std::vector<LorentzVector>> m_lorentzKeys = TreeColumns::lorentzKeys;
+
+        // Collect the files of the dataset and 
+        // combine their event indices
+        void prepareDataset() {
+            if (!m_cfg.filePaths.empty()) {
+                m_filePaths = m_cfg.filePaths;
+            }
+            else if (std::filesystem::is_directory(m_cfg.filePath)) {
+                m_filePaths = prepareFilePaths(m_cfg.filePath);
+            }
+            else {
+                m_filePaths = {m_cfg.filePath};
+            }
+            if (m_filePaths.empty()) {
+                throw std::invalid_argument("No input files");
+            }
+
+            m_index = EventIndex();
+            m_index.treeName = m_cfg.treeName;
+            m_fileOffsets.clear();
+
+            std::set<double> matchingDegrees;
+            for (const auto& filePath : m_filePaths) {
+                auto fileIndex = loadIndex(filePath);
+                if (!fileIndex.has_value()) {
+                    fileIndex = scanFile(filePath);
+                    storeIndex(filePath, fileIndex.value());
+                }
+                const auto offset = m_index.nEntries;
+                m_fileOffsets.push_back(offset);
+
+                // Shift the ranges to global entries, joining
+                // events that continue into the next file as
+                // if the files were merged
+                for (const auto& range : fileIndex->ranges) {
+                    EventRange global{
+                        range.eventId, range.start + offset, range.end + offset};
+                    auto& ranges = m_index.ranges;
+                    if (!ranges.empty() && 
+                        ranges.back().eventId == global.eventId &&
+                        ranges.back().end == global.start) {
+                            ranges.back().end = global.end;
+                    }
+                    else {
+                        ranges.push_back(global);
+                    }
+                }
+                for (const auto& [column, summary] : fileIndex->summaries) {
+                    auto [it, inserted] = m_index.summaries.try_emplace(column, summary);
+                    if (!inserted) {
+                        it->second.min = std::min(it->second.min, summary.min);
+                        it->second.max = std::max(it->second.max, summary.max);
+                    }
+                }
+                matchingDegrees.insert(
+                    fileIndex->matchingDegrees.begin(), 
+                    fileIndex->matchingDegrees.end());
+                m_index.nEntries += fileIndex->nEntries;
+                m_index.nInputEvents += fileIndex->nInputEvents;
+            }
+            m_fileOffsets.push_back(m_index.nEntries);
+            m_index.matchingDegrees.assign(
+                matchingDegrees.begin(), matchingDegrees.end());
+
+            buildIndex();
+        }
+
+        // Prepare the chain for reading
+        void prepareTree() {
+            // Chain the files with their known entry
+            // counts, so none of them is opened up front
+            auto chain = new TChain(m_cfg.treeName.c_str());
+            for (std::size_t i = 0; i < m_filePaths.size(); i++) {
+                chain->Add(
+                    m_filePaths.at(i).c_str(), 
+                    m_fileOffsets.at(i + 1) - m_fileOffsets.at(i));
+            }
+            m_tree = chain;
+            m_hasFlags = 
+                m_tree->GetBranch(SkimWriter::overlapBranch) &&
+                m_tree->GetBranch(SkimWriter::multipleBranch);
     
             // Set the branches
             setBranches(m_tree, m_intKeys, m_intColumns);
@@ -177,41 +456,300 @@ struct TrackTreeReader {
             setBranches(m_tree, m_vVector3Keys, m_vVector3Columns);
     
             setBranches(m_tree, m_lorentzKeys, m_lorentzColumns);
+
+            if (m_hasFlags) {
+                m_tree->SetBranchAddress(SkimWriter::overlapBranch, &m_isOverlap);
+                m_tree->SetBranchAddress(SkimWriter::multipleBranch, &m_isMultiple);
+            }
     
-            // Disable all branches and only enable event-id for a first scan of the file
+            // Enable the requested branches
             m_tree->SetBranchStatus("*", false);
-            if(!m_tree->GetBranch("eventId")) {
+            enableColumns();
+
+            // Entries are read in file order, so every
+            // basket only needs to be decompressed once
+            m_tree->SetCacheSize(m_cfg.cacheSize);
+            m_tree->AddBranchToCache("*", true);
+        }
+
+        // Path of the sidecar index file
+        std::string indexPath(const std::string& filePath) const {
+            if (!m_cfg.indexPath.empty() && m_filePaths.size() == 1) {
+                return m_cfg.indexPath;
+            }
+            return EventIndex::defaultPath(filePath, m_cfg.treeName);
+        }
+
+        // Load the sidecar index of a file if 
+        // it is up to date with the file
+        std::optional<EventIndex> loadIndex(const std::string& filePath) const {
+            if (!m_cfg.useIndexCache) {
+                return std::nullopt;
+            }
+            try {
+                auto current = EventIndex::forFile(filePath, m_cfg.treeName);
+                auto cached = EventIndex::read(indexPath(filePath));
+                if (!cached.has_value() || !cached->matches(current)) {
+                    return std::nullopt;
+                }
+                return cached;
+            }
+            catch (const std::filesystem::filesystem_error&) {
+                // Not a local file
+                return std::nullopt;
+            }
+        }
+
+        // Store the index next to the file,
+        // failures only cost a rescan next time
+        void storeIndex(const std::string& filePath, EventIndex& index) const {
+            if (!m_cfg.useIndexCache) {
+                return;
+            }
+            try {
+                auto key = EventIndex::forFile(filePath, m_cfg.treeName);
+                index.fileSize = key.fileSize;
+                index.modTime = key.modTime;
+                index.treeName = key.treeName;
+            }
+            catch (const std::filesystem::filesystem_error&) {
+                return;
+            }
+            index.write(indexPath(filePath));
+        }
+
+        // Scan a file for the event boundaries
+        // and the summaries of the scalar columns
+        EventIndex scanFile(const std::string& filePath) {
+            ScopedTimer timer(Stage::ScanIndex);
+
+            // Open the file and get the tree
+            std::unique_ptr<TFile> file(TFile::Open(filePath.c_str(), "READ"));
+            if (!file || file->IsZombie()) {
+                throw std::invalid_argument("Cannot open " + filePath);
+            }
+            auto tree = static_cast<TTree*>(file->Get(m_cfg.treeName.c_str()));
+            if (!tree) {
+                throw std::invalid_argument(
+                    "Missing " + m_cfg.treeName + " tree in " + filePath);
+            }
+            setBranches(tree, m_intKeys, m_intColumns);
+            setBranches(tree, m_doubleKeys, m_doubleColumns);
+
+            // Disable all branches and only enable the 
+            // scalar ones for a first scan of the file
+            tree->SetBranchStatus("*", false);
+            if(!tree->GetBranch("eventId")) {
                 throw std::invalid_argument("Missing eventId branch");
             }
-            m_tree->SetBranchStatus("eventId", true);
-                        
-            auto nEntries = static_cast<std::size_t>(m_tree->GetEntries());
-        
-            // Add the first entry
-            m_tree->GetEntry(0);
-            m_eventMap.push_back({m_intColumns.at("eventId"), 0ul, 0ul});
-        
+
+            // Scalar columns present in the tree
+            std::vector<std::pair<const char*, const std::int32_t*>> intColumns;
+            for (const auto& [key, member] : m_intKeys) {
+                if (tree->GetBranch(key)) {
+                    tree->SetBranchStatus(key, true);
+                    intColumns.push_back({key, &m_intColumns.at(key)});
+                }
+            }
+            std::vector<std::pair<const char*, const double*>> doubleColumns;
+            for (const auto& [key, member] : m_doubleKeys) {
+                if (tree->GetBranch(key)) {
+                    tree->SetBranchStatus(key, true);
+                    doubleColumns.push_back({key, &m_doubleColumns.at(key)});
+                }
+            }
+            const bool hasMatchingDegree = tree->GetBranch("matchingDegree");
+            const std::int32_t& eventId = m_intColumns.at("eventId");
+            const double& matchingDegree = m_doubleColumns.at("matchingDegree");
+
+            EventIndex index;
+            auto nEntries = static_cast<std::size_t>(tree->GetEntries());
+            index.nEntries = nEntries;
+
+            // Skims store the events of their input
+            if (auto* nInputEvents = 
+                file->Get<TParameter<double>>(SkimWriter::inputEventsName)) {
+                    index.nInputEvents = nInputEvents->GetVal();
+            }
+
+            std::vector<ColumnSummary> intSummaries(intColumns.size());
+            std::vector<ColumnSummary> doubleSummaries(doubleColumns.size());
+            auto update = [] (ColumnSummary& summary, double value, bool first) {
+                summary.min = first ? value : std::min(summary.min, value);
+                summary.max = first ? value : std::max(summary.max, value);
+            };
+
+            std::set<double> matchingDegrees;
+
             // Go through all entries and store the position of the events
-            for (auto i = 1ul; i < nEntries; ++i) {
-                m_tree->GetEntry(i);
-                const auto evtId = m_intColumns.at("eventId");
+            std::uint64_t nBytes = 0;
+            for (auto i = 0ul; i < nEntries; ++i) {
+                nBytes += std::max(tree->GetEntry(i), 0);
+                const std::uint32_t evtId = eventId;
         
-                if (evtId != std::get<0>(m_eventMap.back())) {
-                    std::get<2>(m_eventMap.back()) = i;
-                    m_eventMap.push_back({evtId, i, i});
+                if (index.ranges.empty() || evtId != index.ranges.back().eventId) {
+                    index.ranges.push_back({evtId, i, i + 1});
+                }
+                else {
+                    index.ranges.back().end = i + 1;
+                }
+
+                for (std::size_t k = 0; k < intColumns.size(); k++) {
+                    update(intSummaries.at(k), *intColumns.at(k).second, i == 0);
+                }
+                for (std::size_t k = 0; k < doubleColumns.size(); k++) {
+                    update(doubleSummaries.at(k), *doubleColumns.at(k).second, i == 0);
+                }
+                // Event 0 is never served by getTracksForEvent
+                if (hasMatchingDegree && evtId != 0) {
+                    matchingDegrees.insert(matchingDegree);
                 }
             }
-            // Sort by event id
-            std::sort(m_eventMap.begin(), m_eventMap.end(),
-                [] (const auto& a, const auto& b) {
-                    return std::get<0>(a) < std::get<0>(b);
+            if (nEntries > 0) {
+                for (std::size_t k = 0; k < intColumns.size(); k++) {
+                    index.summaries.emplace(intColumns.at(k).first, intSummaries.at(k));
                 }
-            );
-    
-            std::get<2>(m_eventMap.back()) = nEntries;
-    
-            // Re-Enable all branches
-            m_tree->SetBranchStatus("*", true);
+                for (std::size_t k = 0; k < doubleColumns.size(); k++) {
+                    index.summaries.emplace(doubleColumns.at(k).first, doubleSummaries.at(k));
+                }
+            }
+            index.matchingDegrees.assign(
+                matchingDegrees.begin(), matchingDegrees.end());
+
+            if (Profiler::isEnabled()) {
+                Profiler::add(Stage::ScanIndex, {}, 0, nBytes);
+            }
+            return index;
+        }
+
+        // Build the event id lookup over the entry ranges
+        void buildIndex() {
+            m_eventIndex.clear();
+            m_eventIndex.reserve(m_index.ranges.size());
+            m_nextRange.assign(m_index.ranges.size(), noRange);
+
+            // Last range seen for every event to chain
+            // the ranges in file order
+            std::unordered_map<std::uint32_t, std::size_t> lastRange;
+            for (std::size_t i = 0; i < m_index.ranges.size(); i++) {
+                const auto eventId = m_index.ranges.at(i).eventId;
+                auto [it, inserted] = lastRange.try_emplace(eventId, i);
+                if (inserted) {
+                    m_eventIndex.emplace(eventId, i);
+                }
+                else {
+                    m_nextRange.at(it->second) = i;
+                    it->second = i;
+                }
+            }
+        }
+
+        // Enable the branches of the configured columns
+        // and drop the disabled ones from the key lists
+        //
+        // A skim only holds a subset of the columns, the
+        // missing ones are dropped and read with default 
+        // values when all columns are read. Explicitly
+        // requested columns must be in the tree.
+        void enableColumns() {
+            std::unordered_set<std::string_view> missing;
+            auto dropMissing = [&] (auto& keys) {
+                std::erase_if(keys, 
+                    [&] (const auto& key) {
+                        if (m_tree->GetBranch(key.first)) {
+                            return false;
+                        }
+                        missing.insert(key.first);
+                        return true;
+                    }
+                );
+            };
+            dropMissing(m_intKeys);
+            dropMissing(m_doubleKeys);
+            dropMissing(m_vector3Keys);
+            dropMissing(m_vVector3Keys);
+            dropMissing(m_lorentzKeys);
+
+            if (m_hasFlags) {
+                m_tree->SetBranchStatus(SkimWriter::overlapBranch, true);
+                m_tree->SetBranchStatus(SkimWriter::multipleBranch, true);
+            }
+
+            if (m_cfg.columns.empty()) {
+                m_tree->SetBranchStatus("*", true);
+                return;
+            }
+            std::unordered_set<std::string_view> columns(
+                m_cfg.columns.begin(), m_cfg.columns.end());
+            columns.insert("eventId");
+
+            for (auto column : columns) {
+                if (missing.contains(column)) {
+                    throw std::invalid_argument(
+                        "Missing " + std::string(column) + " branch");
+                }
+            }
+
+            std::size_t nKnown = 0;
+            auto select = [&] (auto& keys) {
+                std::erase_if(keys, 
+                    [&] (const auto& key) {
+                        return !columns.contains(key.first);
+                    }
+                );
+                for (const auto& [key, member] : keys) {
+                    if (!m_tree->GetBranch(key)) {
+                        throw std::invalid_argument(
+                            "Missing " + std::string(key) + " branch");
+                    }
+                    m_tree->SetBranchStatus(key, true);
+                }
+                nKnown += keys.size();
+            };
+            select(m_intKeys);
+            select(m_doubleKeys);
+            select(m_vector3Keys);
+            select(m_vVector3Keys);
+            select(m_lorentzKeys);
+
+            if (nKnown != columns.size()) {
+                throw std::invalid_argument("Unknown column requested");
+            }
+        }
+
+        // Append the column values to the event columns
+        template <typename T, typename C>
+        inline void appendColumns(
+            EventTracks& tracks,
+            const ColumnKeys<T>& keys,
+            const std::unordered_map<std::string_view, C>& columns) {
+            for (const auto& [key, member] : keys) {
+                appendValue(tracks.*member, columns.at(key));
+            }
+        }
+
+        static void appendValue(std::vector<int>& column, std::int32_t value) {
+            column.push_back(value);
+        }
+
+        static void appendValue(std::vector<double>& column, double value) {
+            column.push_back(value);
+        }
+
+        static void appendValue(std::vector<Vector3>& column, const TVector3* value) {
+            column.push_back({value->X(), value->Y(), value->Z()});
+        }
+
+        static void appendValue(
+            std::vector<LorentzVector>& column, const TLorentzVector* value) {
+                column.push_back({value->Px(), value->Py(), value->Pz(), value->E()});
+        }
+
+        static void appendValue(HitColumns& column, const std::vector<TVector3>* value) {
+            for (const auto& hit : *value) {
+                column.push(hit.X(), hit.Y(), hit.Z());
+            }
+            column.endTrack();
         }
     
         // Set the branches of the TTree
@@ -221,11 +759,14 @@ struct TrackTreeReader {
             const K& keys, 
             std::unordered_map<std::string_view, T>& columns) {
             T value = 0;
-            for (auto key : keys) {
+            for (const auto& [key, member] : keys) {
                 columns.insert({key, value});
             }
-            for (auto key : keys) {
-                tree->SetBranchAddress(key, &columns.at(key));
+            // Skims may not hold every branch
+            for (const auto& [key, member] : keys) {
+                if (tree->GetBranch(key)) {
+                    tree->SetBranchAddress(key, &columns.at(key));
+                }
             }
         }
 };
@@ -0,0 +1,289 @@
+#pragma once
+
+#include "include/Types/Track.hpp"
+#include "include/Types/Vector.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+// Hits of one category for all tracks of an event,
+// stored as contiguous coordinate arrays
+struct HitColumns {
+    /// Hit coordinates
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> z;
+
+    /// First hit of every track, followed
+    /// by the total number of hits
+    std::vector<std::uint32_t> offsets = {0};
+
+    // Number of hits of a track
+    std::size_t size(std::size_t track) const {
+        return offsets.at(track + 1) - offsets.at(track);
+    }
+
+    // Hit of a track
+    Vector3 hit(std::size_t track, std::size_t i) const {
+        auto idx = offsets.at(track) + i;
+        return {x.at(idx), y.at(idx), z.at(idx)};
+    }
+
+    // Append a hit to the current track
+    void push(double hx, double hy, double hz) {
+        x.push_back(hx);
+        y.push_back(hy);
+        z.push_back(hz);
+    }
+
+    // Close the current track
+    void endTrack() {
+        offsets.push_back(x.size());
+    }
+
+    // Pad the tracks without stored hits
+    void resize(std::size_t nTracks) {
+        offsets.resize(nTracks + 1, offsets.back());
+    }
+
+    void clear() {
+        x.clear();
+        y.clear();
+        z.clear();
+        offsets.assign(1, 0);
+    }
+};
+
+// Structure-of-arrays container of the tracks
+// of a single event, reused across events
+struct EventTracks {
+    /// Scalar columns
+    std::vector<double> matchingDegree;
+    std::vector<double> chi2;
+    std::vector<int> ndf;
+    std::vector<int> trackId;
+    std::vector<int> eventId;
+
+    /// Kinematic columns
+    std::vector<LorentzVector> ipMomentumTruth;
+    std::vector<Vector3> vertexTruth;
+    std::vector<LorentzVector> ipMomentum;
+    std::vector<Vector3> ipMomentumError;
+    std::vector<Vector3> vertex;
+    std::vector<Vector3> vertexError;
+
+    /// Hit columns
+    HitColumns trueTrackHits;
+    HitColumns trackHits;
+
+    HitColumns predictedTrackHits;
+    HitColumns filteredTrackHits;
+    HitColumns smoothedTrackHits;
+
+    HitColumns truePredictedResiduals;
+    HitColumns trueFilteredResiduals;
+    HitColumns trueSmoothedResiduals;
+
+    HitColumns predictedResiduals;
+    HitColumns filteredResiduals;
+    HitColumns smoothedResiduals;
+
+    HitColumns truePredictedPulls;
+    HitColumns trueFilteredPulls;
+    HitColumns trueSmoothedPulls;
+
+    HitColumns predictedPulls;
+    HitColumns filteredPulls;
+    HitColumns smoothedPulls;
+
+    /// Overlap flags
+    std::vector<std::uint8_t> isOverlap;
+
+    /// Multiple tracks in event flags
+    std::vector<std::uint8_t> isMultiple;
+
+    /// Flags read from a skim instead of set
+    /// by the OverlapResolver and removeMultiple
+    bool hasStoredFlags = false;
+
+    /// Processing order of the tracks,
+    /// sorted by removeMultiple
+    std::vector<std::uint32_t> order;
+
+    // Number of tracks
+    std::size_t size() const {
+        return order.size();
+    }
+
+    bool empty() const {
+        return order.empty();
+    }
+
+    // View of a track in the container
+    TrackView view(std::size_t i) const {
+        return TrackView(*this, i);
+    }
+
+    // Copy a track out of the container
+    Track track(std::size_t i) const {
+        Track track;
+        track.matchingDegree = matchingDegree.at(i);
+        track.chi2 = chi2.at(i);
+        track.ndf = ndf.at(i);
+        track.trackId = trackId.at(i);
+        track.eventId = eventId.at(i);
+
+        track.ipMomentumTruth = ipMomentumTruth.at(i);
+        track.vertexTruth = vertexTruth.at(i);
+        track.ipMomentum = ipMomentum.at(i);
+        track.ipMomentumError = ipMomentumError.at(i);
+        track.vertex = vertex.at(i);
+        track.vertexError = vertexError.at(i);
+
+        for (auto [name, member, column] : hitMembers) {
+            auto& hits = track.*member;
+            hits.resize((this->*column).size(i));
+            for (std::size_t k = 0; k < hits.size(); k++) {
+                hits.at(k) = (this->*column).hit(i, k);
+            }
+        }
+
+        track.isOverlap = isOverlap.at(i);
+        track.isMultiple = isMultiple.at(i);
+        return track;
+    }
+
+    // Bring all columns to the given number of tracks,
+    // columns that were not filled get default values
+    void resize(std::size_t nTracks) {
+        matchingDegree.resize(nTracks);
+        chi2.resize(nTracks);
+        ndf.resize(nTracks);
+        trackId.resize(nTracks);
+        eventId.resize(nTracks);
+
+        ipMomentumTruth.resize(nTracks);
+        vertexTruth.resize(nTracks);
+        ipMomentum.resize(nTracks);
+        ipMomentumError.resize(nTracks);
+        vertex.resize(nTracks);
+        vertexError.resize(nTracks);
+
+        for (auto [name, member, column] : hitMembers) {
+            (this->*column).resize(nTracks);
+        }
+
+        isOverlap.resize(nTracks, false);
+        isMultiple.resize(nTracks, false);
+
+        order.resize(nTracks);
+        std::iota(order.begin(), order.end(), 0);
+    }
+
+    // Drop all tracks, keeping the allocations
+    void clear() {
+        matchingDegree.clear();
+        chi2.clear();
+        ndf.clear();
+        trackId.clear();
+        eventId.clear();
+
+        ipMomentumTruth.clear();
+        vertexTruth.clear();
+        ipMomentum.clear();
+        ipMomentumError.clear();
+        vertex.clear();
+        vertexError.clear();
+
+        for (auto [name, member, column] : hitMembers) {
+            (this->*column).clear();
+        }
+
+        isOverlap.clear();
+        isMultiple.clear();
+        hasStoredFlags = false;
+        order.clear();
+    }
+
+    // Hit column with its branch name and 
+    // the track member it fills
+    struct HitMember {
+        const char* name;
+        std::vector<Vector3> Track::* track;
+        HitColumns EventTracks::* columns;
+    };
+
+    /// All hit columns
+    static const std::array<HitMember, 17> hitMembers;
+};
+
+inline const std::array<EventTracks::HitMember, 17> EventTracks::hitMembers = {{
+        {"trueTrackHits", &Track::trueTrackHits, &EventTracks::trueTrackHits},
+        {"trackHits", &Track::trackHits, &EventTracks::trackHits},
+        {"predictedTrackHits", &Track::predictedTrackHits, &EventTracks::predictedTrackHits},
+        {"filteredTrackHits", &Track::filteredTrackHits, &EventTracks::filteredTrackHits},
+        {"smoothedTrackHits", &Track::smoothedTrackHits, &EventTracks::smoothedTrackHits},
+        {"truePredictedResiduals", &Track::truePredictedResiduals, &EventTracks::truePredictedResiduals},
+        {"trueFilteredResiduals", &Track::trueFilteredResiduals, &EventTracks::trueFilteredResiduals},
+        {"trueSmoothedResiduals", &Track::trueSmoothedResiduals, &EventTracks::trueSmoothedResiduals},
+        {"predictedResiduals", &Track::predictedResiduals, &EventTracks::predictedResiduals},
+        {"filteredResiduals", &Track::filteredResiduals, &EventTracks::filteredResiduals},
+        {"smoothedResiduals", &Track::smoothedResiduals, &EventTracks::smoothedResiduals},
+        {"truePredictedPulls", &Track::truePredictedPulls, &EventTracks::truePredictedPulls},
+        {"trueFilteredPulls", &Track::trueFilteredPulls, &EventTracks::trueFilteredPulls},
+        {"trueSmoothedPulls", &Track::trueSmoothedPulls, &EventTracks::trueSmoothedPulls},
+        {"predictedPulls", &Track::predictedPulls, &EventTracks::predictedPulls},
+        {"filteredPulls", &Track::filteredPulls, &EventTracks::filteredPulls},
+        {"smoothedPulls", &Track::smoothedPulls, &EventTracks::smoothedPulls}}};
+
+inline TrackView::TrackView(const EventTracks& tracks, std::size_t i) :
+    matchingDegree(tracks.matchingDegree[i]),
+    chi2(tracks.chi2[i]),
+    ndf(tracks.ndf[i]),
+    trackId(tracks.trackId[i]),
+    eventId(tracks.eventId[i]),
+    ipMomentumTruth(tracks.ipMomentumTruth[i]),
+    vertexTruth(tracks.vertexTruth[i]),
+    ipMomentum(tracks.ipMomentum[i]),
+    ipMomentumError(tracks.ipMomentumError[i]),
+    vertex(tracks.vertex[i]),
+    vertexError(tracks.vertexError[i]),
+    isOverlap(tracks.isOverlap[i]),
+    isMultiple(tracks.isMultiple[i]),
+    m_tracks(&tracks),
+    m_index(i) {}
+
+inline HitSpan TrackView::hits(std::vector<Vector3> Track::* member) const {
+    static_assert(sizeof(Vector3) == 3 * sizeof(double), 
+        "Vector3 elements are addressed as strided coordinates");
+    if (m_track) {
+        const auto& hits = m_track->*member;
+        if (hits.empty()) {
+            return {};
+        }
+        return {&hits.front().x, &hits.front().y, &hits.front().z, hits.size(), 3};
+    }
+    for (const auto& [name, trackMember, column] : EventTracks::hitMembers) {
+        if (trackMember != member) {
+            continue;
+        }
+        const auto& hits = m_tracks->*column;
+        const auto first = hits.offsets[m_index];
+        return {
+            hits.x.data() + first, 
+            hits.y.data() + first, 
+            hits.z.data() + first, 
+            hits.size(m_index)};
+    }
+    return {};
+}
+
+inline Track TrackView::materialize() const {
+    if (m_track) {
+        return *m_track;
+    }
+    return m_tracks->track(m_index);
+}
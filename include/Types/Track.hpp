@@ -1,43 +1,47 @@
 #pragma once
 
+#include "include/Types/Vector.hpp"
+
+#include <cstddef>
+#include <functional>
 #include <vector>
 
-#include "TVector3.h"
-#include "TLorentzVector.h"
+struct TrackView;
+struct EventTracks;
 
 struct Track {
-    using Getter = std::function<double(const Track&)>;
+    using Getter = std::function<double(const TrackView&)>;
     
     /// Track hits from the true information
-    std::vector<TVector3> trueTrackHits;
+    std::vector<Vector3> trueTrackHits;
 
     /// Track hits from the measurements
-    std::vector<TVector3> trackHits;
+    std::vector<Vector3> trackHits;
 
     /// KF predicted track hits
-    std::vector<TVector3> predictedTrackHits;
-    std::vector<TVector3> filteredTrackHits;
-    std::vector<TVector3> smoothedTrackHits;
+    std::vector<Vector3> predictedTrackHits;
+    std::vector<Vector3> filteredTrackHits;
+    std::vector<Vector3> smoothedTrackHits;
 
     /// KF residuals with respect to the true hits
-    std::vector<TVector3> truePredictedResiduals;
-    std::vector<TVector3> trueFilteredResiduals;
-    std::vector<TVector3> trueSmoothedResiduals;
+    std::vector<Vector3> truePredictedResiduals;
+    std::vector<Vector3> trueFilteredResiduals;
+    std::vector<Vector3> trueSmoothedResiduals;
 
     /// KF residuals with respect to the measurements
-    std::vector<TVector3> predictedResiduals;
-    std::vector<TVector3> filteredResiduals;
-    std::vector<TVector3> smoothedResiduals;
+    std::vector<Vector3> predictedResiduals;
+    std::vector<Vector3> filteredResiduals;
+    std::vector<Vector3> smoothedResiduals;
 
     /// KF pulls with respect to the true hits
-    std::vector<TVector3> truePredictedPulls;
-    std::vector<TVector3> trueFilteredPulls;
-    std::vector<TVector3> trueSmoothedPulls;
+    std::vector<Vector3> truePredictedPulls;
+    std::vector<Vector3> trueFilteredPulls;
+    std::vector<Vector3> trueSmoothedPulls;
 
     /// KF pulls with respect to the measurements
-    std::vector<TVector3> predictedPulls;
-    std::vector<TVector3> filteredPulls;
-    std::vector<TVector3> smoothedPulls;
+    std::vector<Vector3> predictedPulls;
+    std::vector<Vector3> filteredPulls;
+    std::vector<Vector3> smoothedPulls;
     
     /// Flag indicating how many hits are matched
     /// between the true and the fitted track
@@ -56,20 +60,20 @@ struct Track {
     int eventId;
 
     /// True momentum at the IP
-    TLorentzVector ipMomentumTruth;
+    LorentzVector ipMomentumTruth;
 
     /// True vertex position
-    TVector3 vertexTruth;
+    Vector3 vertexTruth;
 
     /// KF predicted momentum at the IP
-    TLorentzVector ipMomentum;
-    TVector3 ipMomentumError;
+    LorentzVector ipMomentum;
+    Vector3 ipMomentumError;
     
     /// KF predicted vertex position
-    TVector3 vertex;
+    Vector3 vertex;
 
     /// KF predicted vertex error
-    TVector3 vertexError;
+    Vector3 vertexError;
 
     /// Overlap flag
     bool isOverlap = false;
@@ -78,86 +82,164 @@ struct Track {
     bool isMultiple = false;
 };
 
+// Read-only view of the hits of one category of a track,
+// stored either as Vector3 elements or as coordinate columns
+struct HitSpan {
+    const double* x = nullptr;
+    const double* y = nullptr;
+    const double* z = nullptr;
+
+    /// Number of hits
+    std::size_t n = 0;
+
+    /// Distance between consecutive coordinates
+    std::size_t stride = 1;
+
+    std::size_t size() const {
+        return n;
+    }
+
+    bool empty() const {
+        return n == 0;
+    }
+
+    Vector3 operator[](std::size_t i) const {
+        return {x[i * stride], y[i * stride], z[i * stride]};
+    }
+};
+
+// Read-only view of a track stored either in a Track
+// or in the staging buffer of an EventTracks container,
+// that the getters are evaluated on
+//
+// A view bound to a container is only valid while the
+// event is staged, tracks that outlive the event have
+// to be copied out with materialize
+struct TrackView {
+    TrackView(const Track& track) :
+        matchingDegree(track.matchingDegree),
+        chi2(track.chi2),
+        ndf(track.ndf),
+        trackId(track.trackId),
+        eventId(track.eventId),
+        ipMomentumTruth(track.ipMomentumTruth),
+        vertexTruth(track.vertexTruth),
+        ipMomentum(track.ipMomentum),
+        ipMomentumError(track.ipMomentumError),
+        vertex(track.vertex),
+        vertexError(track.vertexError),
+        isOverlap(track.isOverlap),
+        isMultiple(track.isMultiple),
+        m_track(&track) {}
+
+    TrackView(const EventTracks& tracks, std::size_t i);
+
+    // Hits of a category, e.g. hits(&Track::trackHits)
+    HitSpan hits(std::vector<Vector3> Track::* member) const;
+
+    // Copy the track out of its storage
+    Track materialize() const;
+
+    const double& matchingDegree;
+    const double& chi2;
+    const int& ndf;
+    const int& trackId;
+    const int& eventId;
+    const LorentzVector& ipMomentumTruth;
+    const Vector3& vertexTruth;
+    const LorentzVector& ipMomentum;
+    const Vector3& ipMomentumError;
+    const Vector3& vertex;
+    const Vector3& vertexError;
+    bool isOverlap;
+    bool isMultiple;
+
+    private:
+        const Track* m_track = nullptr;
+        const EventTracks* m_tracks = nullptr;
+        std::size_t m_index = 0;
+};
+
 namespace TrackGetters {
 
     /// ---------------------------------------------
     /// D.o.F. performance
 
-    static auto matchingDegree = [] (const Track& track) {
+    static auto matchingDegree = [] (const TrackView& track) {
         return track.matchingDegree;
     };
 
-    static auto ndf = [] (const Track& track) {
+    static auto ndf = [] (const TrackView& track) {
         return track.ndf;
     };
 
     /// ---------------------------------------------
     /// Inter-track performance
 
-    static auto isOverlap = [] (const Track& track) {
+    static auto isOverlap = [] (const TrackView& track) {
         return track.isOverlap;
     };
 
-    static auto isMultiple = [] (const Track& track) {
+    static auto isMultiple = [] (const TrackView& track) {
         return track.isMultiple;
     };
 
     /// ---------------------------------------------
     /// KF fit performance
 
-    static auto chi2ndf = [] (const Track& track) {
+    static auto chi2ndf = [] (const TrackView& track) {
         return track.chi2/track.ndf;
     };
 
-    // static auto smoothedResidualsX = [] (const Track& track) {
+    // static auto smoothedResidualsX = [] (const TrackView& track) {
         // return track.smoothedResiduals;
     // };
 
     /// ---------------------------------------------
     /// KF-estimated kinematics
 
-    static auto ipPx = [] (const Track& track) {
+    static auto ipPx = [] (const TrackView& track) {
         return track.ipMomentum.Px();
     };
 
-    static auto ipPy = [] (const Track& track) {
+    static auto ipPy = [] (const TrackView& track) {
         return track.ipMomentum.Py();
     };
 
-    static auto ipPz = [] (const Track& track) {
+    static auto ipPz = [] (const TrackView& track) {
         return track.ipMomentum.Pz();
     };
 
-    static auto E = [] (const Track& track) {
+    static auto E = [] (const TrackView& track) {
         return track.ipMomentum.E();
     };
 
-    // static auto vertexX = [] (const Track& track) {
+    // static auto vertexX = [] (const TrackView& track) {
         // return track.vertex.X();
     // };
-    // static auto vertexY = [] (const Track& track) {
+    // static auto vertexY = [] (const TrackView& track) {
         // return track.vertex.Y();
     // };
-    // static auto vertexZ = [] (const Track& track) {
+    // static auto vertexZ = [] (const TrackView& track) {
         // return track.vertex.Z();
     // };
 
     /// ---------------------------------------------
     /// Truth kinematics
 
-    static auto ipPxTruth = [] (const Track& track) {
+    static auto ipPxTruth = [] (const TrackView& track) {
         return track.ipMomentumTruth.Px();
     };
 
-    static auto ipPyTruth = [] (const Track& track) {
+    static auto ipPyTruth = [] (const TrackView& track) {
         return track.ipMomentumTruth.Py();
     };
 
-    static auto ipPzTruth = [] (const Track& track) {
+    static auto ipPzTruth = [] (const TrackView& track) {
         return track.ipMomentumTruth.Pz();
     };
 
-    static auto ETruth = [] (const Track& track) {
+    static auto ETruth = [] (const TrackView& track) {
         return track.ipMomentumTruth.E();
     };
 
@@ -165,19 +247,19 @@ namespace TrackGetters {
     /// ---------------------------------------------
     /// Kinematics errors
 
-    static auto ipPxErr = [] (const Track& track) {
+    static auto ipPxErr = [] (const TrackView& track) {
         return (track.ipMomentumTruth.Px() - track.ipMomentum.Px()) / 
             track.ipMomentumTruth.Px();
     };
-    static auto ipPyErr = [] (const Track& track) {
+    static auto ipPyErr = [] (const TrackView& track) {
         return (track.ipMomentumTruth.Py() - track.ipMomentum.Py()) / 
             track.ipMomentumTruth.Py();
     };
-    static auto ipPzErr = [] (const Track& track) {
+    static auto ipPzErr = [] (const TrackView& track) {
         return (track.ipMomentumTruth.Pz() - track.ipMomentum.Pz()) / 
             track.ipMomentumTruth.Pz();
     };
-    static auto EErr = [] (const Track& track) {
+    static auto EErr = [] (const TrackView& track) {
         return (track.ipMomentumTruth.E() - track.ipMomentum.E()) / 
             track.ipMomentumTruth.E();
     };
@@ -185,19 +267,19 @@ namespace TrackGetters {
     /// ---------------------------------------------
     /// Significances
 
-    static auto vertexXSignificance = [] (const Track& track) {
+    static auto vertexXSignificance = [] (const TrackView& track) {
         return track.vertex.X()/track.vertexError.X();
     };
 
-    static auto vertexZSignificance = [] (const Track& track) {
+    static auto vertexZSignificance = [] (const TrackView& track) {
         return track.vertex.Z()/track.vertexError.Z();
     };
 
-    static auto ipMomentumPhiSignificance = [] (const Track& track) {
+    static auto ipMomentumPhiSignificance = [] (const TrackView& track) {
         return (track.ipMomentum.Phi() - M_PI_2)/track.ipMomentumError.X();
     };
 
-    static auto ipMomentumThetaSignificance = [] (const Track& track) {
+    static auto ipMomentumThetaSignificance = [] (const TrackView& track) {
         return (track.ipMomentum.Theta() - M_PI_2)/track.ipMomentumError.Y();
     };
 
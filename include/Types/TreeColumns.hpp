@@ -0,0 +1,43 @@
+#pragma once
+
+#include "include/Types/EventTracks.hpp"
+#include "include/Types/Vector.hpp"
+
+#include <utility>
+#include <vector>
+
+// Columns of the fitted-tracks tree and the event
+// columns they are stored in, shared by the readers
+// and the writers of the tree and of the cache
+namespace TreeColumns {
+    template <typename T>
+    using Keys = std::vector<std::pair<const char*, T EventTracks::*>>;
+
+    inline const Keys<std::vector<int>> intKeys = {
+        {"trackId", &EventTracks::trackId},
+        {"eventId", &EventTracks::eventId},
+        {"ndf", &EventTracks::ndf}};
+
+    inline const Keys<std::vector<double>> doubleKeys = {
+        {"chi2", &EventTracks::chi2},
+        {"matchingDegree", &EventTracks::matchingDegree}};
+
+    inline const Keys<std::vector<Vector3>> vector3Keys = {
+        {"ipMomentumError", &EventTracks::ipMomentumError},
+        {"vertex", &EventTracks::vertex},
+        {"vertexError", &EventTracks::vertexError},
+        {"vertexTruth", &EventTracks::vertexTruth}};
+
+    // Hit columns, in the order of EventTracks::hitMembers
+    inline const Keys<HitColumns> hitKeys = [] {
+        Keys<HitColumns> keys;
+        for (const auto& [name, trackMember, member] : EventTracks::hitMembers) {
+            keys.push_back({name, member});
+        }
+        return keys;
+    }();
+
+    inline const Keys<std::vector<LorentzVector>> lorentzKeys = {
+        {"ipMomentum", &EventTracks::ipMomentum},
+        {"ipMomentumTruth", &EventTracks::ipMomentumTruth}};
+} // namespace TreeColumns
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cmath>
+
+// Plain three-vector with the subset of the
+// TVector3 interface used by the analysis
+struct Vector3 {
+    double x = 0;
+    double y = 0;
+    double z = 0;
+
+    double X() const { return x; }
+    double Y() const { return y; }
+    double Z() const { return z; }
+
+    double Perp() const {
+        return std::sqrt(x * x + y * y);
+    }
+
+    double Mag() const {
+        return std::sqrt(x * x + y * y + z * z);
+    }
+
+    // Same conventions as TVector3
+    double Phi() const {
+        return (x == 0.0 && y == 0.0) ? 0.0 : std::atan2(y, x);
+    }
+
+    double Theta() const {
+        return (x == 0.0 && y == 0.0 && z == 0.0) ? 0.0 : std::atan2(Perp(), z);
+    }
+
+    bool operator==(const Vector3& other) const {
+        return x == other.x && y == other.y && z == other.z;
+    }
+};
+
+// Plain four-vector with the subset of the
+// TLorentzVector interface used by the analysis
+struct LorentzVector {
+    double px = 0;
+    double py = 0;
+    double pz = 0;
+    double e = 0;
+
+    double Px() const { return px; }
+    double Py() const { return py; }
+    double Pz() const { return pz; }
+    double E() const { return e; }
+
+    Vector3 Vect() const {
+        return {px, py, pz};
+    }
+
+    double P() const {
+        return Vect().Mag();
+    }
+
+    double Phi() const {
+        return Vect().Phi();
+    }
+
+    double Theta() const {
+        return Vect().Theta();
+    }
+};
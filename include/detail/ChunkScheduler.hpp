@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+
+// Scheduler handing out chunk indices to workers
+//
+// Chunks are handed out in merge order from a single
+// counter, so every worker walks the file in order and
+// a chunk only finishes ahead of the merge by the few
+// chunks the other workers are still busy with. A worker
+// asking for a chunk more than the window ahead of the
+// merge waits until the merge catches up, which bounds
+// the number of results held for the ordered merge
+// independently of the size of the input.
+class ChunkScheduler {
+    public:
+        // @par nChunks: number of chunks
+        // @par window: maximal number of chunks
+        // handed out ahead of the merge
+        ChunkScheduler(std::size_t nChunks, std::size_t window)
+            : m_nChunks(nChunks), m_window(std::max<std::size_t>(window, 1)) {}
+
+        // Get the next chunk, waiting while it is
+        // too far ahead of the merge
+        //
+        // @return: chunk index, or nothing if all
+        // chunks have been handed out or the
+        // scheduler was stopped
+        std::optional<std::size_t> next() {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_stop || m_next >= m_nChunks) {
+                return std::nullopt;
+            }
+            const std::size_t chunk = m_next++;
+
+            // Every earlier chunk is handed out,
+            // so the merge keeps advancing
+            m_cv.wait(lock, [&] { return m_stop || chunk < m_nMerged + m_window; });
+            if (m_stop) {
+                return std::nullopt;
+            }
+            return chunk;
+        }
+
+        // Report the number of merged chunks
+        void merged(std::size_t nMerged) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_nMerged = nMerged;
+            }
+            m_cv.notify_all();
+        }
+
+        // Stop handing out chunks, e.g. after an error
+        void stop() {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_cv.notify_all();
+        }
+
+    private:
+        std::size_t m_nChunks;
+        std::size_t m_window;
+
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+
+        /// Next chunk to hand out
+        std::size_t m_next = 0;
+        /// Number of merged chunks
+        std::size_t m_nMerged = 0;
+
+        bool m_stop = false;
+};
@@ -0,0 +1,316 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Stages of the pipeline timed by the profiler
+enum class Stage : std::uint8_t {
+    /// Scan of a file for the event index
+    ScanIndex,
+    /// Reading of an event, including
+    /// GetEntry and CopyColumns
+    ReadEvent,
+    /// Decompression of the entries
+    GetEntry,
+    /// Copy of the entries into the event container
+    CopyColumns,
+    RemoveOverlaps,
+    RemoveMultiple,
+    Cuts,
+    FillHistograms,
+    /// Merge of the chunk results
+    Merge,
+    /// Cut flows and confidence intervals
+    CutFlow,
+    /// Writing of the results, including CutFlow
+    Write
+};
+
+inline constexpr std::array<const char*, 11> stageNames = {
+    "ScanIndex", "ReadEvent", "GetEntry", "CopyColumns",
+    "RemoveOverlaps", "RemoveMultiple", "Cuts", "FillHistograms",
+    "Merge", "CutFlow", "Write"};
+
+// Collector of per-thread stage timers and counters
+//
+// Every thread accumulates into its own record, so timing
+// a stage takes no lock. When the profiler is disabled, a
+// timed scope costs a single relaxed load. The records are
+// only read by summary and writeTrace, after the workers
+// are joined.
+class Profiler {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        struct Config {
+            /// Record the timed scopes for the trace
+            bool trace = false;
+            /// Maximal number of trace events per thread,
+            /// later ones are only counted
+            std::size_t maxTraceEvents = 1'000'000;
+        };
+
+        // Accumulated time and counts of a stage
+        struct StageCounters {
+            std::chrono::nanoseconds time{0};
+            std::uint64_t calls = 0;
+            std::uint64_t bytes = 0;
+        };
+
+        // Timed scope in the trace
+        struct TraceEvent {
+            Stage stage;
+            Clock::time_point start;
+            Clock::duration duration;
+        };
+
+        // Counters of a single thread
+        struct ThreadRecord {
+            std::size_t id = 0;
+            std::array<StageCounters, stageNames.size()> stages = {};
+            std::uint64_t nEvents = 0;
+            std::vector<TraceEvent> traceEvents;
+            std::uint64_t nDroppedEvents = 0;
+        };
+
+        // Start profiling, before any worker is started
+        static void enable() {
+            enable(Config());
+        }
+
+        static void enable(const Config& cfg) {
+            auto& profiler = instance();
+            std::lock_guard<std::mutex> lock(profiler.m_mutex);
+            profiler.m_cfg = cfg;
+            profiler.m_start = Clock::now();
+            s_tracing.store(cfg.trace, std::memory_order_relaxed);
+            s_enabled.store(true, std::memory_order_relaxed);
+        }
+
+        static bool isEnabled() {
+            return s_enabled.load(std::memory_order_relaxed);
+        }
+
+        static bool isTracing() {
+            return s_tracing.load(std::memory_order_relaxed);
+        }
+
+        // Add a timed scope of a stage
+        //
+        // @par stage: timed stage
+        // @par start: start of the scope
+        // @par end: end of the scope
+        static void record(Stage stage, Clock::time_point start, Clock::time_point end) {
+            auto& thread = threadRecord();
+            auto& counters = thread.stages[static_cast<std::size_t>(stage)];
+            counters.time += end - start;
+            counters.calls++;
+
+            if (!isTracing()) {
+                return;
+            }
+            if (thread.traceEvents.size() < instance().m_cfg.maxTraceEvents) {
+                thread.traceEvents.push_back({stage, start, end - start});
+            }
+            else {
+                thread.nDroppedEvents++;
+            }
+        }
+
+        // Add time accumulated over several calls, for
+        // stages too fine-grained for a timed scope
+        static void add(
+            Stage stage,
+            Clock::duration time,
+            std::uint64_t calls,
+            std::uint64_t bytes = 0) {
+                auto& counters = threadRecord().stages[static_cast<std::size_t>(stage)];
+                counters.time += time;
+                counters.calls += calls;
+                counters.bytes += bytes;
+        }
+
+        // Count an analyzed event
+        static void addEvent() {
+            if (isEnabled()) {
+                threadRecord().nEvents++;
+            }
+        }
+
+        // Print the stage times summed over the threads
+        //
+        // Throughputs are given per stage as if the
+        // stage was the only one, to compare the stages
+        static void summary(std::ostream& out) {
+            auto& profiler = instance();
+            std::lock_guard<std::mutex> lock(profiler.m_mutex);
+
+            std::array<StageCounters, stageNames.size()> stages = {};
+            std::uint64_t nEvents = 0;
+            std::uint64_t nDropped = 0;
+            for (const auto& thread : profiler.m_threads) {
+                for (std::size_t s = 0; s < stages.size(); s++) {
+                    stages[s].time += thread->stages[s].time;
+                    stages[s].calls += thread->stages[s].calls;
+                    stages[s].bytes += thread->stages[s].bytes;
+                }
+                nEvents += thread->nEvents;
+                nDropped += thread->nDroppedEvents;
+            }
+            const double wallTime = seconds(Clock::now() - profiler.m_start);
+
+            out << "Profile over " << profiler.m_threads.size() << " threads, "
+                << nEvents << " events in " << std::fixed << std::setprecision(3)
+                << wallTime << " s";
+            if (wallTime > 0) {
+                out << ", " << std::setprecision(1) << nEvents / wallTime << " events/s";
+            }
+            out << "\n";
+
+            out << std::left << std::setw(16) << "Stage" << std::right
+                << std::setw(12) << "Time [s]"
+                << std::setw(14) << "Calls"
+                << std::setw(14) << "Per call [us]"
+                << std::setw(14) << "Events/s"
+                << std::setw(14) << "Read [MB]"
+                << std::setw(12) << "MB/s" << "\n";
+            for (std::size_t s = 0; s < stages.size(); s++) {
+                const auto& counters = stages[s];
+                if (counters.calls == 0) {
+                    continue;
+                }
+                const double time = seconds(counters.time);
+                const double megabytes = counters.bytes / 1e6;
+                out << std::left << std::setw(16) << stageNames[s] << std::right
+                    << std::setprecision(3) << std::setw(12) << time
+                    << std::setw(14) << counters.calls
+                    << std::setprecision(2) << std::setw(14)
+                    << 1e6 * time / counters.calls
+                    << std::setprecision(1) << std::setw(14)
+                    << (time > 0 ? nEvents / time : 0)
+                    << std::setw(14) << megabytes
+                    << std::setw(12) << (time > 0 ? megabytes / time : 0) << "\n";
+            }
+            if (nDropped > 0) {
+                out << nDropped << " scopes beyond the trace limit were not traced\n";
+            }
+            out << std::defaultfloat;
+        }
+
+        // Write the traced scopes as a Chrome trace,
+        // readable by chrome://tracing and Perfetto
+        //
+        // @par path: path of the JSON file
+        static void writeTrace(const std::string& path) {
+            auto& profiler = instance();
+            std::lock_guard<std::mutex> lock(profiler.m_mutex);
+
+            std::ofstream out(path);
+            if (!out) {
+                throw std::invalid_argument("Cannot write the trace to " + path);
+            }
+            auto micros = [] (auto time) {
+                return std::chrono::duration<double, std::micro>(time).count();
+            };
+
+            out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+            bool first = true;
+            for (const auto& thread : profiler.m_threads) {
+                out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\""
+                    << ",\"pid\":1,\"tid\":" << thread->id
+                    << ",\"args\":{\"name\":\"thread " << thread->id << "\"}}";
+                first = false;
+
+                for (const auto& event : thread->traceEvents) {
+                    out << ",\n{\"name\":\"" << stageNames[static_cast<std::size_t>(event.stage)]
+                        << "\",\"cat\":\"stage\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->id
+                        << std::fixed << std::setprecision(3)
+                        << ",\"ts\":" << micros(event.start - profiler.m_start)
+                        << ",\"dur\":" << micros(event.duration) << "}";
+                }
+            }
+            out << "\n]}\n";
+        }
+
+    private:
+        Config m_cfg;
+
+        // Outside of the instance, so that checking
+        // them needs no guard of the static local
+        static inline std::atomic<bool> s_enabled = false;
+        static inline std::atomic<bool> s_tracing = false;
+
+        Clock::time_point m_start = Clock::now();
+
+        // Records of every thread that timed a stage,
+        // kept beyond the lifetime of the threads
+        std::vector<std::unique_ptr<ThreadRecord>> m_threads;
+        std::mutex m_mutex;
+
+        static Profiler& instance() {
+            static Profiler profiler;
+            return profiler;
+        }
+
+        // Record of the calling thread,
+        // registered on first use
+        static ThreadRecord& threadRecord() {
+            thread_local ThreadRecord* record = nullptr;
+            if (!record) {
+                auto& profiler = instance();
+                std::lock_guard<std::mutex> lock(profiler.m_mutex);
+                profiler.m_threads.push_back(std::make_unique<ThreadRecord>());
+                record = profiler.m_threads.back().get();
+                record->id = profiler.m_threads.size();
+            }
+            return *record;
+        }
+
+        template <typename Duration>
+        static double seconds(Duration time) {
+            return std::chrono::duration<double>(time).count();
+        }
+};
+
+// Times the enclosing scope as a stage
+// if the profiler is enabled
+class ScopedTimer {
+    public:
+        ScopedTimer(Stage stage) : m_stage(stage) {
+            if (Profiler::isEnabled()) {
+                m_active = true;
+                m_start = Profiler::Clock::now();
+            }
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+        ~ScopedTimer() {
+            stop();
+        }
+
+        // End the scope before the end of the block
+        void stop() {
+            if (m_active) {
+                Profiler::record(m_stage, m_start, Profiler::Clock::now());
+                m_active = false;
+            }
+        }
+
+    private:
+        Stage m_stage;
+        bool m_active = false;
+        Profiler::Clock::time_point m_start;
+};
@@ -1,81 +1,268 @@
+#include <exception>
 #include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
 
+#include "include/Io/ColumnarTrackReader.hpp"
 #include "include/Io/TrackTreeReader.hpp"
+#include "include/Io/Shard.hpp"
+#include "include/Analysis/AnalysisEngine.hpp"
+#include "include/Analysis/Checkpoint.hpp"
+#include "include/Analysis/CutScan.hpp"
+#include "include/Analysis/ParallelAnalysis.hpp"
 #include "include/Analysis/EventStats.hpp"
+#include "include/Analysis/PartialResult.hpp"
 #include "include/Analysis/TrackHistogramSet.hpp"
 #include "include/detail/HelperFunctions.hpp"
+#include "include/detail/Profiler.hpp"
 
-int processTracks() {
-    // Input directory
-    std::string filePath = 
-        "/home/romanurmanov/lab/LUXE/acts_tracking/E320Pipeline_analysis/data/background_rejection/merged/fitted-tracks-bkg-full-merged.root";
+// Command line options of the analysis
+struct Options {
+    /// Input file, directory of per-BX files,
+    /// or columnar cache if columnar is set
+    std::string inputPath;
+    /// Output file
+    std::string outputPath;
 
-    // Output directory
-    std::string outPath = 
-        "/home/romanurmanov/lab/LUXE/acts_tracking/E320Pipeline_analysis/analysisScript/processed/root/fitted-tracks-bkg-full-processed.root";
+    std::optional<Shard> shard;
+    std::optional<std::string> checkpointPath;
+    std::vector<ScanAxis> scanAxes;
+    bool columnar = false;
 
-    TrackTreeReader::Config trackTreeReaderCfg;
-    trackTreeReaderCfg.filePath = filePath;
+    /// Read-ahead pipeline instead of the
+    /// chunked parallel analysis, if set
+    std::optional<ReadAheadConfig> readAhead;
+};
 
-    TrackTreeReader trackTreeReader(trackTreeReaderCfg);
+// Analyze a dataset read by a TrackTreeReader
+// or a ColumnarTrackReader
+template <typename Reader>
+int processTracks(const Reader& reader, const Options& options) {
+    const auto& [inputPath, outputPath, shard, checkpointPath, 
+        scanAxes, columnar, readAhead] = options;
+    std::string outPath = outputPath;
 
     // Initialize cuts
     Cuts cuts; 
     
+    // A shard only processes its slice of the events
+    // and writes the raw results for mergeShards
+    auto events = reader.getEventsInFileOrder();
+    if (shard.has_value()) {
+        events = shard->select(events);
+        outPath.replace(outPath.rfind(".root"), 5, 
+            "-shard" + std::to_string(shard->index) + 
+            "of" + std::to_string(shard->count) + ".root");
+    }
+    if (!scanAxes.empty()) {
+        outPath.replace(outPath.rfind(".root"), 5, "-scan.root");
+    }
+
+    // Events of the input absent from a skim only enter
+    // the cut flow normalization, once over all shards
+    std::size_t nEmptyEvents = 0;
+    if (!shard.has_value() || shard->index == 0) {
+        nEmptyEvents = reader.getInputEvents() - reader.getEventsInFileOrder().size();
+    }
+
     // Process events
     TFile* outFile = new TFile(outPath.c_str(), "RECREATE");
-    
-    auto events = trackTreeReader.getEvents();
 
-    auto allTracks = trackTreeReader.getTracks();
-    auto matchingDegrees = getMatchingDegrees(allTracks); 
+    // A scan fills the histograms and cut flows of
+    // every threshold grid point in a single pass
+    if (!scanAxes.empty()) {
+        ScanEngine scan = processScanParallel(reader, cuts, scanAxes, events);
+        scan.addEmptyEvents(nEmptyEvents);
+        scan.store(outFile);
 
-    double temp = 0;
+        std::cout << "Scanned " << scan.nPoints() << " grid points over " 
+            << scan.nEvents() << " events" << std::endl;
 
-    std::map<double, std::map<int, EventStats>> eventStats;
-    for (auto matchingDegree : matchingDegrees) {
-        TrackHistogramSet histSet(std::to_string(matchingDegree));
+        outFile->Close();
 
-        std::map<int, EventStats> evStat;
-        for (auto id : events) {
-            evStat[id] = EventStats();
+        return 0;
+    }
 
-            auto tracks = trackTreeReader.getTracksForEvent(id);
+    // A checkpointed job only processes the events
+    // missing from the checkpoint and updates it
+    // periodically from the merging worker and once done
+    if (checkpointPath.has_value()) {
+        Checkpoint checkpoint({checkpointPath.value()});
+        auto chunks = checkpoint.plan(reader);
 
-            removeOverlaps(tracks);
-            removeMultiple(tracks);
+        AnalysisEngine engine = processChunksParallel(
+            reader, cuts, chunks, std::thread::hardware_concurrency(),
+            [&checkpoint] (const AnalysisEngine& merged, std::size_t nMerged) {
+                checkpoint.update(merged, nMerged);
+            });
+        checkpoint.write(engine, chunks.size());
 
-            cuts.cuts.at(0).range = {matchingDegree, matchingDegree};
-            for (auto track : tracks) {
-                if (!processTrack(track, evStat.at(id), cuts)) {
-                    continue;
-                }
-                temp++;
+        PartialResult result = checkpoint.result(engine);
+        result.nEvents += nEmptyEvents;
+        result.store(outFile);
 
-                histSet.fill(track);
-            }
-        }
-        storeTrackHistograms(outFile, histSet);
+        std::cout << "Total number of tracks: " << result.nTracks << std::endl;
+        std::cout << "Tracks per event: " << result.nTracks/result.nEvents << std::endl;
 
-        auto [cutFlow, cutFlowErrs] = 
-            getCutFlow(
-                evStat, 
-                std::to_string(matchingDegree));
-        cutFlow->Write();
-        cutFlowErrs->Write();
+        outFile->Close();
 
-        eventStats[matchingDegree] = evStat;
+        return 0;
     }
 
+    // Read every event once and dispatch its
+    // tracks by matching degree on all cores, a
+    // directory of per-BX files one file per core, 
+    // or on this thread while producers decode ahead
+    const bool perFile = !shard.has_value() && reader.getFilePaths().size() > 1;
+    AnalysisEngine engine = 
+        readAhead.has_value() ? processEventsPipelined(reader, cuts, events, readAhead.value()) :
+        perFile ? processFilesParallel(reader, cuts) :
+        processEventsParallel(reader, cuts, events);
+    engine.addEmptyEvents(nEmptyEvents);
+    if (shard.has_value()) {
+        engine.partialResult().write(outFile);
+    }
+    else {
+        engine.store(outFile);
+    }
+
+    double temp = engine.nTracks();
+
     std::cout << "Total number of tracks: " << temp << std::endl;
-    std::cout << "Tracks per event: " << temp/events.size() << std::endl;
+    std::cout << "Tracks per event: " << temp/engine.nEvents() << std::endl;
 
     outFile->Close();
 
     return 0;
 }
 
-int main() {
-    processTracks();
-    return 0;
+int processTracks(const Options& options) {
+    // Repeated passes read the columnar cache
+    // written by convertToColumnar instead
+    if (options.columnar) {
+        ColumnarTrackReader::Config columnarReaderCfg;
+        columnarReaderCfg.filePath = options.inputPath;
+        columnarReaderCfg.columns = AnalysisEngine::requiredColumns();
+
+        ColumnarTrackReader columnarReader(columnarReaderCfg);
+        return processTracks(columnarReader, options);
+    }
+
+    TrackTreeReader::Config trackTreeReaderCfg;
+    trackTreeReaderCfg.filePath = options.inputPath;
+    trackTreeReaderCfg.columns = AnalysisEngine::requiredColumns();
+
+    TrackTreeReader reader(trackTreeReaderCfg);
+    return processTracks(reader, options);
+}
+
+// Usage: offlineAnalysis <input> <output>
+//     [--shard i/N | --checkpoint <file> | 
+//     --scan cut:lower|upper:t1,t2,... [--scan ...]] 
+//     [--read-ahead [--queue-depth N] [--batch-size N]]
+//     [--columnar] [--profile] [--trace <file>]
+//
+// The input is a fitted-tracks file or a directory of
+// per-BX files, or a columnar cache with --columnar
+int main(int argc, char** argv) {
+    const std::string usage = std::string("Usage: ") + argv[0] + 
+        " <input> <output> [--shard i/N | --checkpoint <file> | --scan cut:lower|upper:t1,t2,... [--scan ...]]"
+        " [--read-ahead [--queue-depth N] [--batch-size N]]"
+        " [--columnar] [--profile] [--trace <file>]\n";
+    Options options;
+    auto& [inputPath, outputPath, shard, checkpointPath, 
+        scanAxes, columnar, readAhead] = options;
+    std::vector<std::string> positional;
+    bool profile = false;
+    std::optional<std::string> tracePath;
+    // Malformed shard, scan and number arguments throw
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--profile") {
+                profile = true;
+            }
+            else if (arg == "--trace" && i + 1 < argc) {
+                tracePath = argv[++i];
+            }
+            else if (arg == "--read-ahead") {
+                readAhead = readAhead.value_or(ReadAheadConfig());
+            }
+            else if (arg == "--queue-depth" && i + 1 < argc) {
+                readAhead = readAhead.value_or(ReadAheadConfig());
+                readAhead->queueDepth = std::stoul(argv[++i]);
+            }
+            else if (arg == "--batch-size" && i + 1 < argc) {
+                readAhead = readAhead.value_or(ReadAheadConfig());
+                readAhead->batchSize = std::stoul(argv[++i]);
+            }
+            else if (arg == "--columnar") {
+                columnar = true;
+            }
+            else if (arg == "--shard" && i + 1 < argc) {
+                shard = Shard::parse(argv[++i]);
+            }
+            else if (arg == "--checkpoint" && i + 1 < argc) {
+                checkpointPath = argv[++i];
+            }
+            else if (arg == "--scan" && i + 1 < argc) {
+                scanAxes.push_back(ScanAxis::parse(argv[++i]));
+            }
+            else if (!arg.starts_with("--")) {
+                positional.push_back(arg);
+            }
+            else {
+                std::cerr << usage;
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << "\n" << usage;
+        return 1;
+    }
+    // The shard and scan outputs are
+    // named after the output file
+    if (positional.size() != 2 || !positional.at(1).ends_with(".root")) {
+        std::cerr << usage;
+        return 1;
+    }
+    inputPath = positional.at(0);
+    outputPath = positional.at(1);
+
+    // Shards are merged by mergeShards instead,
+    // and the modes exclude each other. The read-ahead
+    // pipeline replaces the chunked analysis of all
+    // events or of a shard.
+    if (shard.has_value() + checkpointPath.has_value() + !scanAxes.empty() > 1 ||
+        (readAhead.has_value() && (checkpointPath.has_value() || !scanAxes.empty()))) {
+        std::cerr << usage;
+        return 1;
+    }
+
+    // Stage timings of the whole job, 
+    // including the scan of the inputs
+    if (profile || tracePath.has_value()) {
+        Profiler::Config profilerCfg;
+        profilerCfg.trace = tracePath.has_value();
+        Profiler::enable(profilerCfg);
+    }
+    // Invalid inputs and scan grids only
+    // show up once the analysis starts
+    int status = 1;
+    try {
+        status = processTracks(options);
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
+    if (profile) {
+        Profiler::summary(std::cout);
+    }
+    if (tracePath.has_value()) {
+        Profiler::writeTrace(tracePath.value());
+    }
+    return status;
 }
\ No newline at end of file
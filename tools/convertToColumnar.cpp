@@ -0,0 +1,33 @@
+#include <iostream>
+#include <string>
+
+#include "include/Io/TrackTreeReader.hpp"
+#include "include/Io/ColumnarTrackReader.hpp"
+#include "include/Analysis/AnalysisEngine.hpp"
+
+// Convert a fitted-tracks file or directory of per-BX
+// files into the memory-mapped columnar cache
+//
+// Usage: convertToColumnar <input> <output> [--all-columns]
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <input> <output> [--all-columns]\n";
+        return 1;
+    }
+
+    TrackTreeReader::Config trackTreeReaderCfg;
+    trackTreeReaderCfg.filePath = argv[1];
+    // Only the analysis columns are 
+    // stored unless asked otherwise
+    if (argc < 4 || std::string(argv[3]) != "--all-columns") {
+        trackTreeReaderCfg.columns = AnalysisEngine::requiredColumns();
+    }
+
+    TrackTreeReader trackTreeReader(trackTreeReaderCfg);
+    writeColumnarCache(trackTreeReader, argv[2]);
+
+    std::cout << "Converted " << trackTreeReader.getEventsInFileOrder().size() 
+        << " events to " << argv[2] << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "include/Io/SkimWriter.hpp"
+#include "include/Io/SyntheticTracks.hpp"
+#include "include/Types/EventTracks.hpp"
+
+// Parse a comma separated list of degree:weight pairs
+std::vector<std::pair<double, double>> parseMatchingDegrees(const std::string& list) {
+    std::vector<std::pair<double, double>> degrees;
+    std::istringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        auto colon = item.find(':');
+        if (colon == std::string::npos) {
+            degrees.push_back({std::stod(item), 1});
+        }
+        else {
+            degrees.push_back(
+                {std::stod(item.substr(0, colon)), std::stod(item.substr(colon + 1))});
+        }
+    }
+    return degrees;
+}
+
+// Write synthetic fitted-tracks trees with the schema
+// TrackTreeReader expects, for scaling and stress tests
+//
+// Events are generated one at a time, so the output size
+// is only bound by the disk. With several files the output
+// is a directory of per-BX files read as one dataset.
+// Shuffled events are written out of id order, split
+// events have their tracks in two separate entry ranges.
+// Events without tracks have no entries, they are only
+// counted in the number of input events of every file.
+//
+// Usage: generateTracks <output> [--events N] [--tracks MEAN]
+//     [--fixed-tracks] [--hits N] [--matching-degrees d:w,...]
+//     [--shared-hits RATE] [--shuffle FRACTION] [--split FRACTION]
+//     [--files N] [--seed N] [--compression N] [--basket-size N]
+int main(int argc, char** argv) {
+    const std::string usage = std::string("Usage: ") + argv[0] +
+        " <output> [--events N] [--tracks MEAN] [--fixed-tracks] [--hits N]"
+        " [--matching-degrees d:w,...] [--shared-hits RATE] [--shuffle FRACTION]"
+        " [--split FRACTION] [--files N] [--seed N] [--compression N]"
+        " [--basket-size N]\n";
+    if (argc < 2) {
+        std::cerr << usage;
+        return 1;
+    }
+
+    std::size_t nEvents = 1000;
+    std::size_t nFiles = 1;
+    double shuffleRate = 0;
+    double splitRate = 0;
+    SyntheticTracks::Config syntheticCfg;
+    SkimWriter::Config skimWriterCfg;
+    skimWriterCfg.storeFlags = false;
+    std::optional<SyntheticTracks> generator;
+    // Malformed numbers and invalid
+    // generator settings throw
+    try {
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--fixed-tracks") {
+                syntheticCfg.poissonTracks = false;
+                continue;
+            }
+            if (i + 1 >= argc) {
+                std::cerr << usage;
+                return 1;
+            }
+            if (arg == "--events") {
+                nEvents = std::stoul(argv[++i]);
+            }
+            else if (arg == "--tracks") {
+                syntheticCfg.meanTracks = std::stod(argv[++i]);
+            }
+            else if (arg == "--hits") {
+                syntheticCfg.nHits = std::stoul(argv[++i]);
+            }
+            else if (arg == "--matching-degrees") {
+                syntheticCfg.matchingDegrees = parseMatchingDegrees(argv[++i]);
+            }
+            else if (arg == "--shared-hits") {
+                syntheticCfg.sharedHitRate = std::stod(argv[++i]);
+            }
+            else if (arg == "--shuffle") {
+                shuffleRate = std::stod(argv[++i]);
+            }
+            else if (arg == "--split") {
+                splitRate = std::stod(argv[++i]);
+            }
+            else if (arg == "--files") {
+                nFiles = std::stoul(argv[++i]);
+            }
+            else if (arg == "--seed") {
+                syntheticCfg.seed = std::stoul(argv[++i]);
+            }
+            else if (arg == "--compression") {
+                skimWriterCfg.compression = std::stoi(argv[++i]);
+            }
+            else if (arg == "--basket-size") {
+                skimWriterCfg.basketSize = std::stoi(argv[++i]);
+            }
+            else {
+                std::cerr << usage;
+                return 1;
+            }
+        }
+        generator.emplace(syntheticCfg);
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << "\n" << usage;
+        return 1;
+    }
+    if (nFiles == 0 || nFiles > std::max<std::size_t>(nEvents, 1)) {
+        std::cerr << "Number of files out of range\n";
+        return 1;
+    }
+
+    // Event ids start at 1, shuffled
+    // events swap places with any other
+    std::mt19937_64 rng(syntheticCfg.seed);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    std::vector<std::uint32_t> events(nEvents);
+    std::iota(events.begin(), events.end(), 1);
+    for (std::size_t i = 0; i < nEvents; i++) {
+        if (uniform(rng) < shuffleRate) {
+            auto j = std::uniform_int_distribution<std::size_t>(0, nEvents - 1)(rng);
+            std::swap(events[i], events[j]);
+        }
+    }
+
+    std::vector<std::string> filePaths;
+    if (nFiles == 1) {
+        filePaths.push_back(argv[1]);
+    }
+    else {
+        std::filesystem::create_directories(argv[1]);
+        for (std::size_t k = 0; k < nFiles; k++) {
+            filePaths.push_back((std::filesystem::path(argv[1]) /
+                ("fitted-tracks-event" + std::to_string(k) + ".root")).string());
+        }
+    }
+
+    EventTracks tracks;
+    EventTracks pending;
+    std::vector<std::uint32_t> selected;
+    std::vector<std::uint32_t> pendingSelected;
+    std::size_t nTracks = 0;
+    std::size_t nWrittenEvents = 0;
+    std::uintmax_t nBytes = 0;
+    for (std::size_t k = 0; k < nFiles; k++) {
+        skimWriterCfg.filePath = filePaths.at(k);
+        SkimWriter skimWriter(skimWriterCfg);
+
+        auto first = nEvents * k / nFiles;
+        auto last = nEvents * (k + 1) / nFiles;
+        for (auto e = first; e < last; e++) {
+            generator->generate(events[e], tracks);
+            nTracks += tracks.size();
+            nWrittenEvents += !tracks.empty();
+
+            selected.resize(tracks.size());
+            std::iota(selected.begin(), selected.end(), 0);
+
+            // The second half of a split event
+            // follows the next event
+            const bool split = tracks.size() > 1 && uniform(rng) < splitRate;
+            auto mid = split ? selected.begin() + selected.size() / 2 : selected.end();
+            skimWriter.write(tracks, {selected.begin(), mid});
+            if (!pendingSelected.empty()) {
+                skimWriter.write(pending, pendingSelected);
+                pendingSelected.clear();
+            }
+            if (split) {
+                std::swap(pending, tracks);
+                pendingSelected.assign(mid, selected.end());
+            }
+        }
+        // Split events do not continue into the next file
+        if (!pendingSelected.empty()) {
+            skimWriter.write(pending, pendingSelected);
+            pendingSelected.clear();
+        }
+        skimWriter.setInputEvents(last - first);
+        skimWriter.close();
+        nBytes += std::filesystem::file_size(filePaths.at(k));
+    }
+
+    std::cout << "Generated " << nEvents << " events, " << nWrittenEvents 
+        << " of them with tracks, with " << nTracks << " tracks, " << nBytes / (1 << 20) << " MiB in " << argv[1] << std::endl;
+
+    return 0;
+}
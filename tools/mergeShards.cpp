@@ -0,0 +1,39 @@
+#include <iostream>
+#include <string>
+
+#include "include/Analysis/PartialResult.hpp"
+
+#include "TFile.h"
+
+// Merge the partial results of the shards of a dataset
+// and write the final histograms and cut flows
+//
+// Usage: mergeShards <output> <partial> [<partial> ...]
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <output> <partial> [<partial> ...]\n";
+        return 1;
+    }
+
+    PartialResult merged;
+    for (int i = 2; i < argc; i++) {
+        TFile* file = TFile::Open(argv[i], "READ");
+        if (!file || file->IsZombie()) {
+            std::cerr << "Cannot open " << argv[i] << "\n";
+            return 1;
+        }
+        merged.merge(PartialResult::read(file));
+        file->Close();
+        delete file;
+    }
+
+    TFile* outFile = new TFile(argv[1], "RECREATE");
+    merged.store(outFile);
+
+    std::cout << "Total number of tracks: " << merged.nTracks << std::endl;
+    std::cout << "Tracks per event: " << merged.nTracks / merged.nEvents << std::endl;
+
+    outFile->Close();
+
+    return 0;
+}
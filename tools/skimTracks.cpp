@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "include/Io/TrackTreeReader.hpp"
+#include "include/Io/SkimWriter.hpp"
+#include "include/Analysis/AnalysisUnit.hpp"
+#include "include/Analysis/BatchCuts.hpp"
+#include "include/Analysis/Cuts.hpp"
+#include "include/Analysis/OverlapResolver.hpp"
+#include "include/detail/HelperFunctions.hpp"
+
+// Split a comma separated list
+std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    std::istringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+// Write the tracks passing a subset of the cuts into
+// a slimmed fitted-tracks tree, which TrackTreeReader
+// opens like the original dataset
+//
+// Usage: skimTracks <input> <output> [--cuts a,b,...]
+//     [--columns a,b,...] [--compression N] [--basket-size N]
+int main(int argc, char** argv) {
+    const std::string usage = std::string("Usage: ") + argv[0] +
+        " <input> <output> [--cuts a,b,...] [--columns a,b,...]"
+        " [--compression N] [--basket-size N]\n";
+    if (argc < 3) {
+        std::cerr << usage;
+        return 1;
+    }
+
+    std::vector<std::string> cutNames = {"ndf", "isOverlap", "isMultiple", "chi2ndf"};
+    SkimWriter::Config skimWriterCfg;
+    skimWriterCfg.filePath = argv[2];
+    // Malformed numbers throw
+    try {
+        for (int i = 3; i < argc; i++) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                std::cerr << usage;
+                return 1;
+            }
+            if (arg == "--cuts") {
+                cutNames = splitList(argv[++i]);
+            }
+            else if (arg == "--columns") {
+                skimWriterCfg.columns = splitList(argv[++i]);
+            }
+            else if (arg == "--compression") {
+                skimWriterCfg.compression = std::stoi(argv[++i]);
+            }
+            else if (arg == "--basket-size") {
+                skimWriterCfg.basketSize = std::stoi(argv[++i]);
+            }
+            else {
+                std::cerr << usage;
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << "\n" << usage;
+        return 1;
+    }
+
+    // Keep the cuts of the skim in the analysis order
+    Cuts cuts;
+    std::erase_if(cuts.cuts,
+        [&cutNames] (const Cut& cut) {
+            return std::ranges::find(cutNames, cut.name) == cutNames.end();
+        });
+    if (cuts.cuts.size() != cutNames.size()) {
+        std::cerr << "Unknown cut requested\n";
+        return 1;
+    }
+
+    // Read the written columns and the ones the cuts
+    // and the post-processing need, or everything
+    TrackTreeReader::Config trackTreeReaderCfg;
+    trackTreeReaderCfg.filePath = argv[1];
+    if (!skimWriterCfg.columns.empty()) {
+        std::vector<AnalysisUnit> cutUnits;
+        for (const auto& unit : units) {
+            if (std::ranges::find(cutNames, unit.name) != cutNames.end()) {
+                cutUnits.push_back(unit);
+            }
+        }
+        auto columns = requiredColumns(cutUnits);
+        columns.insert(columns.end(),
+            postProcessingColumns.begin(), postProcessingColumns.end());
+        columns.insert(columns.end(),
+            skimWriterCfg.columns.begin(), skimWriterCfg.columns.end());
+
+        std::sort(columns.begin(), columns.end());
+        columns.erase(std::unique(columns.begin(), columns.end()), columns.end());
+        trackTreeReaderCfg.columns = columns;
+    }
+
+    TrackTreeReader trackTreeReader(trackTreeReaderCfg);
+    SkimWriter skimWriter(skimWriterCfg);
+
+    // The resolver keeps its hit index across events
+    OverlapResolver overlapResolver(cuts.overlaps);
+    BatchCuts batchCuts;
+    std::vector<std::uint32_t> selected;
+    std::size_t nTracks = 0;
+    trackTreeReader.forEachEvent(
+        [&] (std::uint32_t, EventTracks& tracks) {
+            if (!tracks.hasStoredFlags) {
+                overlapResolver.resolve(tracks);
+                removeMultiple(tracks);
+            }
+            nTracks += tracks.size();
+
+            // Tracks keep their order in the input
+            const auto& masks = batchCuts.evaluate(tracks, cuts, false);
+            selected.clear();
+            for (std::uint32_t i = 0; i < tracks.size(); i++) {
+                if (BatchCuts::passes(masks[i], cuts.cuts.size())) {
+                    selected.push_back(i);
+                }
+            }
+            skimWriter.write(tracks, selected);
+        }
+    );
+    // A skim of a skim keeps the events of the original input
+    skimWriter.setInputEvents(trackTreeReader.getInputEvents());
+    skimWriter.close();
+
+    std::cout << "Kept " << skimWriter.nWritten() << " of " << nTracks
+        << " tracks in " << argv[2] << std::endl;
+
+    return 0;
+}